@@ -1,5 +1,6 @@
 #pragma once
 
+#include <utility>
 #include <vector>
 
 #include <bulk/bulk.hpp>
@@ -31,4 +32,73 @@ long owner_min(bulk::var<T>& x) {
     return best_proc;
 }
 
+/**
+ * Hashes an id. The sum of the hashes of a set of ids is used as a fingerprint
+ * of that set, so it can be computed from partial sums on different processors.
+ */
+inline size_t hash_id(long id) {
+    auto x = (size_t)id + 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+/**
+ * A second hash of an id, independent of hash_id. Sets are only considered
+ * equal if the sums of both hashes match, which makes a false match of two
+ * different sets negligible.
+ */
+inline size_t hash_id_2(long id) {
+    auto x = (size_t)id + 0x632be59bd9b4e019;
+    x = (x ^ (x >> 33)) * 0xff51afd7ed558ccd;
+    x = (x ^ (x >> 33)) * 0xc4ceb9fe1a85ec53;
+    return x ^ (x >> 33);
+}
+
+/**
+ * A queue of (id, value) pairs that packs all pairs for the same processor into
+ * a single message, instead of sending a message or doing a remote access per id.
+ */
+template <typename T>
+class batched_queue {
+  public:
+    batched_queue(bulk::world& world)
+    : world_(world), queue_(world), ids_(world.active_processors()),
+      values_(world.active_processors()) {}
+
+    // adds the pair to the message for processor t
+    void send(int t, long id, T value) {
+        ids_[t].push_back(id);
+        values_[t].push_back(value);
+    }
+
+    // sends the messages and synchronizes, after which the pairs sent to this
+    // processor are available in received()
+    void sync() {
+        for (auto t = 0; t < world_.active_processors(); t++) {
+            if (!ids_[t].empty()) {
+                queue_(t).send(ids_[t], values_[t]);
+                ids_[t].clear();
+                values_[t].clear();
+            }
+        }
+        world_.sync();
+        received_.clear();
+        for (const auto& [ids, values] : queue_) {
+            for (auto i = 0u; i < ids.size(); i++) {
+                received_.emplace_back(ids[i], values[i]);
+            }
+        }
+    }
+
+    const std::vector<std::pair<long, T>>& received() const { return received_; }
+
+  private:
+    bulk::world& world_;
+    bulk::queue<long[], T[]> queue_;
+    std::vector<std::vector<long>> ids_;
+    std::vector<std::vector<T>> values_;
+    std::vector<std::pair<long, T>> received_;
+};
+
 } // namespace pmondriaan
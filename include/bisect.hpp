@@ -1,15 +1,35 @@
 #pragma once
 
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
 
+#include "hypergraph/contraction.hpp"
 #include "hypergraph/hypergraph.hpp"
 #include "options.hpp"
 #include "util/interval.hpp"
 
 namespace pmondriaan {
 
+/**
+ * The coarsened hypergraphs and contractions created in the coarsening phase
+ * of a multilevel bisection, of which the first nc_par are distributed.
+ */
+struct coarsening_levels {
+    std::vector<pmondriaan::hypergraph> HC_list;
+    std::vector<pmondriaan::contraction> C_list;
+    size_t nc_par;
+    size_t nc_tot;
+    pmondriaan::hierarchy hierarchy;
+    // the replicated hypergraph at level nc_par if it is shared by all threads,
+    // in which case HC_list[nc_par] is an empty placeholder
+    std::shared_ptr<pmondriaan::hypergraph> shared;
+    // if true, the coarsened hypergraphs keep an existing bisection, which is
+    // refined instead of computing an initial partitioning
+    bool partitioned = false;
+};
+
 /**
  * Bisect a hypergraph using the given bisection method and returns the weights of the two parts.
  */
@@ -23,6 +43,26 @@ std::vector<long> bisect(bulk::world& world,
                          interval labels,
                          std::mt19937& rng);
 
+/**
+ * Bisect a hypergraph using the given bisection method and returns the weights
+ * of the two parts. The coarsening hierarchy of a parent bisection containing
+ * the vertices is reused and the new hierarchy is stored in hierarchy. If
+ * bisection_cut is not a nullptr, the multilevel bisection stores the cutsize
+ * of the bisection in it.
+ */
+std::vector<long> bisect(bulk::world& world,
+                         pmondriaan::hypergraph& H,
+                         pmondriaan::options& opts,
+                         long max_weight_0,
+                         long max_weight_1,
+                         long start,
+                         long end,
+                         interval labels,
+                         std::mt19937& rng,
+                         pmondriaan::hierarchy& parent,
+                         pmondriaan::hierarchy& hierarchy,
+                         long* bisection_cut = nullptr);
+
 /**
  * Randomly bisects a hypergraph under the balance constraint and returns the weights of the two parts.
  */
@@ -47,4 +87,75 @@ std::vector<long> bisect_multilevel(bulk::world& world,
                                     interval labels,
                                     std::mt19937& rng);
 
-} // namespace pmondriaan
\ No newline at end of file
+/**
+ * Bisects a hypergraph using the multilevel framework, reusing the sequential
+ * coarsening hierarchy of a parent bisection. If bisection_cut is not a
+ * nullptr, the cutsize of the bisection is stored in it.
+ */
+std::vector<long> bisect_multilevel(bulk::world& world,
+                                    pmondriaan::hypergraph& H,
+                                    pmondriaan::options& opts,
+                                    long max_weight_0,
+                                    long max_weight_1,
+                                    long start,
+                                    long end,
+                                    interval labels,
+                                    std::mt19937& rng,
+                                    pmondriaan::hierarchy& parent,
+                                    pmondriaan::hierarchy& hierarchy,
+                                    long* bisection_cut = nullptr);
+
+/**
+ * Performs the coarsening phase of the multilevel framework on the vertices of
+ * H with indices between start and end. If partition is not a nullptr, the
+ * vertices are bisected into the parts partition.low and partition.high, and
+ * only vertices in the same part are contracted.
+ */
+coarsening_levels coarsen_multilevel(bulk::world& world,
+                                     pmondriaan::hypergraph& H,
+                                     pmondriaan::options& opts,
+                                     long start,
+                                     long end,
+                                     std::mt19937& rng,
+                                     pmondriaan::hierarchy& parent,
+                                     interval* partition = nullptr);
+
+/**
+ * Performs the initial partitioning and uncoarsening phases of the multilevel
+ * framework on the coarsened hypergraphs in levels and labels the vertices of H.
+ * Returns the weights of the two parts. If bisection_cut is not a nullptr, the
+ * cutsize of the bisection is stored in it.
+ */
+std::vector<long> uncoarsen_multilevel(bulk::world& world,
+                                       pmondriaan::hypergraph& H,
+                                       pmondriaan::options& opts,
+                                       long max_weight_0,
+                                       long max_weight_1,
+                                       interval labels,
+                                       std::mt19937& rng,
+                                       coarsening_levels& levels,
+                                       long* bisection_cut = nullptr);
+
+/**
+ * Improves the multilevel bisection of the vertices of H with indices between
+ * start and end, labelled with labels, by V-cycles. Every cycle coarsens
+ * without contracting vertices of different parts and refines the bisection
+ * again while uncoarsening. A cycle that does not lower the cutsize is undone
+ * and ends the cycles. At most opts.vcycles cycles are done, and no new cycle
+ * starts after opts.vcycle_time_limit milliseconds if it is positive.
+ * cut_size is the cutsize of the bisection and is updated. Returns the
+ * weights of the two parts.
+ */
+std::vector<long> vcycle_multilevel(bulk::world& world,
+                                    pmondriaan::hypergraph& H,
+                                    pmondriaan::options& opts,
+                                    long max_weight_0,
+                                    long max_weight_1,
+                                    long start,
+                                    long end,
+                                    interval labels,
+                                    std::mt19937& rng,
+                                    std::vector<long> weight_parts,
+                                    long& cut_size);
+
+} // namespace pmondriaan
\ No newline at end of file
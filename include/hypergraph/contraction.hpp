@@ -1,5 +1,6 @@
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 
 #include <bulk/bulk.hpp>
@@ -76,6 +77,13 @@ class contraction {
                                            long max_weight_1,
                                            std::mt19937& rng);
 
+    /**
+     * Marks that all vertices matched in this contraction are identical to
+     * their sample, so uncoarsening does not change the cutsize.
+     */
+    void set_identical(bool value) { identical_ = value; }
+    bool identical() { return identical_; }
+
     auto& matches(long sample) { return matches_[sample]; }
 
     long id_sample(long i) { return ids_samples_[i]; }
@@ -92,6 +100,7 @@ class contraction {
     std::vector<std::pair<long, long>> free_vertices_;
     long local_free_weight_;
     long global_free_weight_;
+    bool identical_ = false;
 
     void add_free_vertex_(long id, long weight) {
         free_vertices_.push_back(std::make_pair(id, weight));
@@ -109,5 +118,26 @@ class contraction {
                                std::mt19937& rng);
 };
 
+/**
+ * A hierarchy stores for each level of a sequence of contractions which
+ * vertex represents the cluster a vertex was contracted into.
+ */
+class hierarchy {
+  public:
+    /**
+     * Adds the clustering of the contraction C as the next level.
+     */
+    void add_level(pmondriaan::contraction& C);
+
+    /**
+     * Returns the id of the vertex representing the cluster of vertex id at the given level.
+     */
+    long representative(long id, size_t level);
+
+    size_t levels() { return levels_.size(); }
+
+  private:
+    std::vector<std::unordered_map<long, long>> levels_;
+};
 
 } // namespace pmondriaan
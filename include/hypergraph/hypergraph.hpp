@@ -18,6 +18,8 @@
 
 namespace pmondriaan {
 
+class net_directory;
+
 /**
  * A vertex has an id, a weight of type T and a list of the nets it is contained in.
  */
@@ -78,6 +80,35 @@ class net {
     size_t global_size_ = 0;
 };
 
+/**
+ * A set of local net ids, used to keep track of the nets whose counts changed
+ * so that they can be processed without scanning all nets.
+ */
+class dirty_nets {
+  public:
+    dirty_nets(size_t nr_nets) : dirty_(nr_nets, false) {}
+
+    void insert(long n) {
+        if (!dirty_[n]) {
+            dirty_[n] = true;
+            nets_.push_back(n);
+        }
+    }
+
+    const std::vector<long>& nets() const { return nets_; }
+
+    void clear() {
+        for (auto n : nets_) {
+            dirty_[n] = false;
+        }
+        nets_.clear();
+    }
+
+  private:
+    std::vector<bool> dirty_;
+    std::vector<long> nets_;
+};
+
 /**
  * A hypergraph.
  */
@@ -97,9 +128,10 @@ class hypergraph {
 
     hypergraph(const hypergraph& other)
     : global_size_(other.global_size_), global_number_nets_(other.global_number_nets_),
-      vertices_(other.vertices_), nr_nz_(other.nr_nz_) {
+      vertices_(other.vertices_), nr_nz_(other.nr_nz_),
+      duplicate_nets_(other.duplicate_nets_) {
         for (const auto& n : other.nets()) {
-            nets_.push_back(pmondriaan::net(n.id(), std::vector<long>()));
+            nets_.push_back(pmondriaan::net(n.id(), std::vector<long>(), n.cost()));
             nets_.back().set_global_size(n.global_size());
         }
 
@@ -114,6 +146,7 @@ class hypergraph {
     }
 
     hypergraph(hypergraph&& other) = default;
+    hypergraph& operator=(hypergraph&& other) = default;
 
     // computes the total weight of the vertices
     long total_weight();
@@ -165,20 +198,28 @@ class hypergraph {
     // moves a vertex to the other part in 0,1 and adjusts the vector with counts of the parts
     void move(long id, std::vector<std::vector<long>>& C);
 
-    // moves a vertex to the other part in 0,1 and adjusts the vector with counts of the parts for parallel hypergraph
-    void move(long id, std::vector<std::vector<long>>& C, std::vector<std::vector<long>>& C_loc);
+    // moves a vertex to the other part in 0,1 and adjusts the vector with counts of the parts for
+    // parallel hypergraph, the nets of the vertex are added to changed if it is not a nullptr
+    void move(long id,
+              std::vector<std::vector<long>>& C,
+              std::vector<std::vector<long>>& C_loc,
+              pmondriaan::dirty_nets* changed = nullptr);
 
     // updates the global_to_local map
     void update_map();
 
+    // updates the global_to_local map for the vertices with local id between start and end
+    void update_map(long start, long end);
+
     // updates the map for the nets
     void update_map_nets();
 
     long local_id(long global_id) {
-        assert(global_to_local.find(global_id) != global_to_local.end());
-        assert(global_to_local[global_id] >= 0 &&
-               (size_t)global_to_local[global_id] < vertices_.size());
-        return global_to_local[global_id];
+        // find does not modify the map, so vertices can be looked up concurrently
+        auto local = global_to_local.find(global_id);
+        assert(local != global_to_local.end());
+        assert(local->second >= 0 && (size_t)local->second < vertices_.size());
+        return local->second;
     }
 
     long local_id_net(long global_id) const {
@@ -208,10 +249,11 @@ class hypergraph {
     const std::vector<pmondriaan::net>& nets() const { return nets_; }
 
     pmondriaan::net& net(long id) {
-        assert(net_global_to_local.find(id) != net_global_to_local.end());
-        auto local_id = net_global_to_local[id];
-        assert(local_id >= 0 && (size_t)local_id < nets_.size());
-        return nets_[local_id];
+        // find does not modify the map, so a shared hypergraph can be read concurrently
+        auto local = net_global_to_local.find(id);
+        assert(local != net_global_to_local.end());
+        assert(local->second >= 0 && (size_t)local->second < nets_.size());
+        return nets_[local->second];
     }
 
     auto size() { return vertices_.size(); }
@@ -246,6 +288,12 @@ std::vector<std::vector<long>> init_counts(pmondriaan::hypergraph& H);
  */
 std::vector<std::vector<long>> init_counts(bulk::world& world, pmondriaan::hypergraph& H);
 
+/**
+ * Initialize the counts for parts 0,1 for a parallel hypergraph using its net directory.
+ */
+std::vector<std::vector<long>>
+init_counts(bulk::world& world, pmondriaan::hypergraph& H, pmondriaan::net_directory& directory);
+
 /**
  * Recompute the global size of a hypergraph.
  */
@@ -276,6 +324,27 @@ double load_balance(pmondriaan::hypergraph& H, long k);
  */
 double load_balance(bulk::world& world, pmondriaan::hypergraph& H, long k);
 
+/**
+ * The contribution to the cutsize of a net with the given cost that is present in lambda parts.
+ */
+long cutsize_net(long lambda, long cost, pmondriaan::m metric);
+
+/**
+ * The contribution to the cutsize of a net with the given cost that is present
+ * in lambda parts, for a metric known at compile time.
+ */
+template <pmondriaan::m metric>
+long cutsize_net(long lambda, long cost) {
+    if (lambda <= 1) {
+        return 0;
+    }
+    if constexpr (metric == pmondriaan::m::cut_net) {
+        return cost;
+    } else {
+        return (lambda - 1) * cost;
+    }
+}
+
 /**
  * Compute the cutsize with the correct metric of a local hypergraph
  */
@@ -286,6 +355,14 @@ long cutsize(pmondriaan::hypergraph& H, pmondriaan::m metric);
  */
 long cutsize(bulk::world& world, pmondriaan::hypergraph& H, pmondriaan::m metric);
 
+/**
+ * Compute the cutsize with the correct metric of a distributed hypergraph using its net directory
+ */
+long cutsize(bulk::world& world,
+             pmondriaan::hypergraph& H,
+             pmondriaan::m metric,
+             pmondriaan::net_directory& directory);
+
 /**
  * Compute the cutsize of a bisected hypergraph using the vector C of the counts of all nets
  */
@@ -296,6 +373,12 @@ long cutsize(pmondriaan::hypergraph& H, std::vector<std::vector<long>>& C);
  */
 std::vector<size_t> global_net_sizes(bulk::world& world, pmondriaan::hypergraph& H);
 
+/**
+ * Compute the global net sizes of a hypergraph using its net directory.
+ */
+std::vector<size_t>
+global_net_sizes(bulk::world& world, pmondriaan::hypergraph& H, pmondriaan::net_directory& directory);
+
 /**
  * Removes all free nets.
  */
@@ -311,6 +394,12 @@ void remove_free_nets(pmondriaan::hypergraph& H, size_t max_size);
  */
 void simplify_duplicate_nets(pmondriaan::hypergraph& H);
 
+/**
+ * Simplifies all duplicate nets for a distributed hypergraph. Nets are
+ * compared using fingerprints that are combined at the owner of the net.
+ */
+void simplify_duplicate_nets(bulk::world& world, pmondriaan::hypergraph& H);
+
 /**
  * Creates a new hypergraph that only contains the vertices of H with local id between start and end.
  */
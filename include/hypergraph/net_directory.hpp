@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+#else
+#include <bulk/backends/thread/thread.hpp>
+#endif
+
+#include "hypergraph/hypergraph.hpp"
+
+namespace pmondriaan {
+
+/**
+ * The directory of the nets of a distributed hypergraph. Every processor is
+ * responsible for a contiguous range of net ids, for which it knows the cost,
+ * the global size and the processors holding pins of the net. The directory is
+ * built once per hypergraph level, it stays valid while the nets and the
+ * distribution of the vertices do not change.
+ */
+class net_directory {
+  public:
+    // builds the directory, if balanced the ranges are chosen such that every
+    // processor is responsible for about the same number of pins
+    net_directory(bulk::world& world, pmondriaan::hypergraph& H, bool balanced = false);
+
+    // the processor responsible for the net with global id n
+    int owner(long n) const {
+        return (int)(std::upper_bound(begin_.begin(), begin_.end(), n) - begin_.begin()) - 1;
+    }
+
+    // the index of the net with global id n among the nets of its owner
+    long local(long n) const { return n - begin_[owner(n)]; }
+
+    // the global id of the net with the given index on this processor
+    long global(long index) const { return begin_[rank_] + index; }
+
+    // the number of net ids this processor is responsible for
+    size_t local_count() const { return begin_[rank_ + 1] - begin_[rank_]; }
+
+    long cost(long index) const { return cost_[index]; }
+    size_t global_size(long index) const { return global_size_[index]; }
+    const std::vector<int>& procs(long index) const { return procs_[index]; }
+
+  private:
+    int rank_;
+    std::vector<long> begin_;
+    std::vector<long> cost_;
+    std::vector<size_t> global_size_;
+    std::vector<std::vector<int>> procs_;
+};
+
+} // namespace pmondriaan
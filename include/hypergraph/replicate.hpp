@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+#else
+#include <bulk/backends/thread/thread.hpp>
+#endif
+
+#include "hypergraph/hypergraph.hpp"
+
+namespace pmondriaan {
+
+/**
+ * Serializes the vertices of H as a sequence of id, weight, part, degree and nets per vertex.
+ */
+std::vector<long> serialize_vertices(pmondriaan::hypergraph& H);
+
+/**
+ * Returns a hypergraph containing all vertices and nets of the distributed
+ * hypergraph H on every processor. The local parts are gathered using
+ * recursive doubling in ceil(log2(p)) supersteps, the local vertices of a
+ * processor come first in its copy.
+ */
+pmondriaan::hypergraph replicate_hypergraph(bulk::world& world, pmondriaan::hypergraph& H);
+
+#ifndef BACKEND_MPI
+/**
+ * Returns a hypergraph containing all vertices and nets of the distributed
+ * hypergraph H that is shared by all threads. It is built once by processor 0
+ * directly from the local hypergraphs, after which its duplicate nets are
+ * simplified. The shared hypergraph is read-only and must not be modified.
+ */
+std::shared_ptr<pmondriaan::hypergraph>
+replicate_hypergraph_shared(bulk::world& world, pmondriaan::hypergraph& H);
+#endif
+
+} // namespace pmondriaan
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+#else
+#include <bulk/backends/thread/thread.hpp>
+#endif
+
+#include "hypergraph/hypergraph.hpp"
+#include "hypergraph/net_directory.hpp"
+#include "options.hpp"
+
+namespace pmondriaan {
+
+/**
+ * Adds change to the count of key in counts, which are stored as (key, count)
+ * pairs sorted by key. Keys whose count becomes 0 are removed.
+ */
+void add_count(std::vector<std::pair<long, long>>& counts, long key, long change);
+
+/**
+ * The global number of pins of each net in each part of a distributed k-way
+ * partitioning. The counts of a net are stored as a list of (part, count)
+ * pairs sorted by part, containing only the parts the net is in. Vertices are
+ * moved using the local view of the counts, after which the counts are
+ * synchronized once through the processors that own the nets.
+ */
+class kway_counts {
+  public:
+    kway_counts(bulk::world& world,
+                pmondriaan::hypergraph& H,
+                pmondriaan::net_directory& directory,
+                pmondriaan::m metric);
+
+    // the counts of the net with local index i
+    const std::vector<std::pair<long, long>>& operator[](long i) const { return counts_[i]; }
+
+    // moves the vertex with local id i to part
+    void move(long i, long part);
+
+    // sends the changed counts to the owners and receives the new global
+    // counts, returns the new global cutsize
+    long synchronize();
+
+    // computes the global cutsize
+    long cut_size();
+
+    // the number of pins of a net with the given counts in part
+    static long count(const std::vector<std::pair<long, long>>& counts, long part);
+
+  private:
+    // sends the counts of the given owned nets to the processors holding their pins
+    void send_counts(const std::vector<long>& nets);
+
+    bulk::world& world_;
+    pmondriaan::hypergraph& H_;
+    pmondriaan::net_directory& directory_;
+    pmondriaan::m metric_;
+    std::vector<std::vector<std::pair<long, long>>> counts_;
+    std::vector<std::vector<std::pair<long, long>>> owned_counts_;
+    long cut_size_my_nets_ = 0;
+    std::vector<bool> touched_;
+    // the changes made since the last synchronization, as net, part and change
+    bulk::queue<long, long, long> changes_;
+    bulk::queue<long, long[], long[]> counts_queue_;
+};
+
+/**
+ * Refines the k-way partitioning of the distributed hypergraph H, keeping the
+ * weight of every part at most max_weight. In each round every processor moves
+ * its vertices to the part with the largest positive gain, in alternating
+ * rounds only to parts with a higher or with a lower label, after which the
+ * counts are synchronized. A round that increases the cutsize is undone.
+ * Returns the cutsize of the refined partitioning.
+ */
+long kway_refine_par(bulk::world& world,
+                     pmondriaan::hypergraph& H,
+                     long k,
+                     long max_weight,
+                     pmondriaan::options& opts);
+
+} // namespace pmondriaan
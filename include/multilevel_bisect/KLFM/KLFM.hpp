@@ -9,11 +9,13 @@
 #endif
 
 #include "hypergraph/hypergraph.hpp"
+#include "multilevel_bisect/KLFM/stopping_rule.hpp"
 
 namespace pmondriaan {
 
 /**
  * Runs the KLFM algorithm to improve a given partitioning. Return the quality of the best solution.
+ * If stats is not a nullptr, the moves done and rolled back are added to it.
  */
 long KLFM(pmondriaan::hypergraph& H,
           std::vector<std::vector<long>>& C,
@@ -23,10 +25,13 @@ long KLFM(pmondriaan::hypergraph& H,
           long max_weight_1,
           pmondriaan::options& opts,
           std::mt19937& rng,
-          long cut_size = std::numeric_limits<long>::max());
+          long cut_size = std::numeric_limits<long>::max(),
+          pmondriaan::KLFM_statistics* stats = nullptr);
 
 /**
  * Runs a single pass of the KLFM algorithm to improve a given partitioning.
+ * The pass stops after KLFM_max_no_gain_moves moves without improvement, or
+ * when the adaptive stopping rule says so if KLFM_adaptive_stopping.
  */
 long KLFM_pass(pmondriaan::hypergraph& H,
                std::vector<std::vector<long>>& C,
@@ -35,7 +40,8 @@ long KLFM_pass(pmondriaan::hypergraph& H,
                long max_weight_0,
                long max_weight_1,
                pmondriaan::options& opts,
-               std::mt19937& rng);
+               std::mt19937& rng,
+               pmondriaan::KLFM_statistics* stats = nullptr);
 
 long make_balanced(pmondriaan::hypergraph& H,
                    std::vector<std::vector<long>>& C,
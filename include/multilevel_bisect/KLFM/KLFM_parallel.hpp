@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <limits>
 #include <random>
 
@@ -11,12 +12,16 @@
 #endif
 
 #include "hypergraph/hypergraph.hpp"
+#include "hypergraph/net_directory.hpp"
 #include "multilevel_bisect/KLFM/gain_buckets.hpp"
+#include "multilevel_bisect/KLFM/stopping_rule.hpp"
 
 namespace pmondriaan {
 
 /**
  * Runs the KLFM algorithm in parallel to improve a given partitioning. Return the quality of the best solution.
+ * The net directory of H is built if it is not given. If stats is not a nullptr, the local moves
+ * done and rolled back are added to it.
  */
 long KLFM_par(bulk::world& world,
               pmondriaan::hypergraph& H,
@@ -27,10 +32,14 @@ long KLFM_par(bulk::world& world,
               long max_weight_1,
               pmondriaan::options& opts,
               std::mt19937& rng,
-              long cut_size = std::numeric_limits<long>::max());
+              long cut_size = std::numeric_limits<long>::max(),
+              pmondriaan::net_directory* directory = nullptr,
+              pmondriaan::KLFM_statistics* stats = nullptr);
 
 /**
  * Runs a single pass of the KLFM algorithm to improve a given partitioning.
+ * If KLFM_adaptive_stopping, the pass also stops when the adaptive stopping
+ * rule says so, using the change in cutsize of every round as a step.
  */
 long KLFM_pass_par(bulk::world& world,
                    pmondriaan::hypergraph& H,
@@ -40,38 +49,28 @@ long KLFM_pass_par(bulk::world& world,
                    std::array<long, 2>& total_weights,
                    long max_weight_0,
                    long max_weight_1,
-                   bulk::coarray<long>& cost_my_nets,
-                   std::vector<std::vector<int>>& procs_my_nets,
+                   pmondriaan::net_directory& directory,
                    pmondriaan::options& opts,
-                   std::mt19937& rng);
+                   std::mt19937& rng,
+                   pmondriaan::KLFM_statistics* stats = nullptr);
 
 /**
- * Initializes the cost of the nets a processor is responsible for. Also stores
- * what processors have vertices in each of these nets.
- */
-void init_cost_my_nets(bulk::world& world,
-                       pmondriaan::hypergraph& H,
-                       bulk::coarray<long>& cost_my_nets,
-                       std::vector<std::vector<int>>& procs_my_nets);
-
-/**
- * Initializes the previous_C counts using communication and return the cutsize
- * of the nets the processor is responsible for.
+ * Initializes the previous_C counts of the nets the processor is responsible
+ * for using communication and return the cutsize of these nets.
  */
 long init_previous_C(bulk::world& world,
                      pmondriaan::hypergraph& H,
                      std::vector<std::vector<long>>& C,
-                     bulk::coarray<long>& previous_C,
-                     bulk::block_partitioning<1>& net_partition,
-                     bulk::coarray<long>& cost_my_nets);
+                     std::vector<long>& previous_C,
+                     pmondriaan::net_directory& directory);
 
 /**
  * Updates the gain values that were outdated.
  */
 void update_gains(pmondriaan::hypergraph& H,
                   pmondriaan::net& net,
-                  std::vector<long> C_loc,
-                  std::vector<long> C_new,
+                  const std::vector<long>& C_loc,
+                  const std::array<long, 2>& C_new,
                   pmondriaan::gain_structure& gain_structure);
 
 /**
@@ -84,34 +83,44 @@ void find_top_moves(pmondriaan::hypergraph& H,
                     std::array<long, 2>& weights,
                     long max_weight_0,
                     long max_weight_1,
-                    std::mt19937& rng);
+                    std::mt19937& rng,
+                    pmondriaan::dirty_nets* changed = nullptr);
+
+/**
+ * Summarizes the moves of a processor for the balance resolution. For the moves
+ * into part 0 and into part 1, the moves are listed in the order in which they
+ * are undone, each as the highest gain so far followed by the total weight so far.
+ */
+std::array<std::vector<long>, 2>
+summarize_moves(std::vector<std::tuple<long, long, long>>& moves);
 
 /**
- * Determines how many moves from part 0 or 1 should be rejected on each processor.
- * Return the number of rejected moves for each processor. This is positive when
- * we have to move back vertices from part 0 to part 1 and positive otherwise.
+ * Determines how many moves from part 0 or 1 should be rejected on each processor,
+ * using the summaries of the moves of all processors. Return the number of rejected
+ * moves for this processor. This is positive when we have to move back vertices
+ * from part 0 to part 1 and negative otherwise.
  */
 long reject_unbalanced_moves(bulk::world& world,
-                             bulk::queue<long, long, int, long>& moves_queue,
+                             bulk::queue<int, long[], long[]>& summaries,
                              std::array<long, 2>& total_weights,
                              long max_weight_0,
                              long max_weight_1);
 
 /**
  * Updates the counts by communicating with the responsible processor, returns the new cutsize_my_nets.
+ * Only the nets in changed_nets and the nets updates are received for are processed, changed_nets
+ * is cleared afterwards. The gains in gain_structure are updated as well, unless it is a nullptr.
  */
 long update_C(bulk::world& world,
               pmondriaan::hypergraph& H,
               std::vector<std::vector<long>>& C,
-              bulk::coarray<long>& previous_C,
+              std::vector<long>& previous_C,
               std::vector<long>& prev_C_0,
               bulk::queue<long, long>& update_nets,
-              bulk::partitioning<1>& net_partition,
-              bulk::coarray<long>& cost_my_nets,
-              std::vector<std::vector<int>>& procs_my_nets,
+              pmondriaan::net_directory& directory,
               long cut_size_my_nets,
-              bool update_g,
-              pmondriaan::gain_structure& gain_structure);
+              pmondriaan::dirty_nets& changed_nets,
+              pmondriaan::gain_structure* gain_structure);
 
 // For testing purposes
 void check_C(bulk::world& world, pmondriaan::hypergraph& H, std::vector<std::vector<long>>& C);
@@ -50,16 +50,12 @@ class gain_buckets {
 /**
  * This structure keeps track of the gain values during a KLFM pass. Each
  * unlocked vertex is contained in the buckets belonging to the part it is in.
+ * The gain computations are specialized for hypergraphs in which all nets have
+ * unit cost, such as the finest level, so they do not look up the nets' costs.
  */
 class gain_structure {
   public:
-    gain_structure(pmondriaan::hypergraph& H, std::vector<std::vector<long>>& C)
-    : H_(H), C_(C) {
-        buckets =
-        std::vector<pmondriaan::gain_buckets>(2, gain_buckets(compute_size_buckets()));
-        gains = std::vector<long>(H.size());
-        init_();
-    }
+    gain_structure(pmondriaan::hypergraph& H, std::vector<std::vector<long>>& C);
 
 
     long part_next(long max_extra_weight_0, long max_extra_weight_1, std::mt19937& rng);
@@ -70,8 +66,8 @@ class gain_structure {
 
     void move(long v);
 
-    // Move vertex using local counts C_loc
-    void move(long v, std::vector<std::vector<long>>& C_loc);
+    // Move vertex using local counts C_loc, the nets of v are added to changed if it is not a nullptr
+    void move(long v, std::vector<std::vector<long>>& C_loc, pmondriaan::dirty_nets* changed = nullptr);
 
     void remove(long v);
 
@@ -81,17 +77,29 @@ class gain_structure {
 
     bool bucket_done(int part) { return buckets[part].next() == -1; }
 
+    // true if all nets of the hypergraph have unit cost
+    bool unit_cost() const { return unit_cost_; }
+
     // for testing purposes
     void check_gains();
 
   private:
+    template <bool unit_cost>
     void init_();
 
+    template <bool unit_cost>
+    void move_(long v);
+
+    template <bool unit_cost>
+    void move_(long v, std::vector<std::vector<long>>& C_loc, pmondriaan::dirty_nets* changed);
+
     pmondriaan::hypergraph& H_;
     std::vector<std::vector<long>>& C_;
     std::vector<pmondriaan::gain_buckets> buckets;
     std::vector<long> gains;
+    bool unit_cost_;
 
+    bool compute_unit_cost();
     long compute_size_buckets();
 };
 
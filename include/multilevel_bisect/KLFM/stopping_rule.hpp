@@ -0,0 +1,40 @@
+#pragma once
+
+namespace pmondriaan {
+
+/**
+ * The number of moves done by KLFM and the number of them that were rolled
+ * back, summed over the passes of a level.
+ */
+struct KLFM_statistics {
+    long moves = 0;
+    long rolled_back = 0;
+};
+
+/**
+ * An adaptive stopping rule for a KLFM pass, which models the gains of the
+ * steps since the last improvement as a random walk. After p steps with mean
+ * gain mu and variance sigma^2, a better solution is unlikely once
+ * p * mu^2 > alpha * sigma^2 + beta, where beta is the logarithm of the
+ * number of vertices. The pass does not stop within the first beta steps.
+ */
+class stopping_rule {
+  public:
+    stopping_rule(double alpha, long size);
+
+    // adds a step with the given gain, the statistics restart if it improved the best solution
+    void add(long gain, bool improved);
+
+    // returns true if the pass should stop
+    bool stop() const;
+
+  private:
+    double alpha_;
+    double beta_;
+    long steps_ = 0;
+    double mean_ = 0.0;
+    // the sum of the squared differences from the mean
+    double squares_ = 0.0;
+};
+
+} // namespace pmondriaan
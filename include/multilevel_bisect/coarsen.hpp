@@ -16,25 +16,31 @@
 namespace pmondriaan {
 
 /**
- * Coarsens the hypergraph H and returns a hypergraph HC in parallel.
+ * Coarsens the hypergraph H and returns a hypergraph HC in parallel. If
+ * same_part, only vertices in the same part are contracted, and the coarsened
+ * vertices keep the part of the vertices they contain.
  */
 pmondriaan::hypergraph coarsen_hypergraph_par(bulk::world& world,
                                               pmondriaan::hypergraph& H,
                                               pmondriaan::contraction& C,
                                               pmondriaan::options& opts,
-                                              std::mt19937& rng);
+                                              std::mt19937& rng,
+                                              bool same_part = false);
 
 
 /**
  * Sends match request to the owners of the best matches found using the
- * improduct computation. Returns the local matches.
+ * improduct computation. Returns the local matches. The samples are received
+ * with their processor, index, part and nets. If same_part, vertices only
+ * request samples in their own part.
  */
 void request_matches(pmondriaan::hypergraph& H,
                      pmondriaan::contraction& C,
-                     bulk::queue<long, long, long[]>& sample_queue,
+                     bulk::queue<long, long, long, long[]>& sample_queue,
                      bulk::queue<long, long>& accepted_matches,
                      const std::vector<long>& indices_samples,
-                     pmondriaan::options opts);
+                     pmondriaan::options opts,
+                     bool same_part = false);
 
 /**
  * First merges the nets and weight of all vertices matched to a sample and
@@ -55,16 +61,39 @@ pmondriaan::hypergraph contract_hypergraph(bulk::world& world,
                                            std::vector<bool>& matched);
 
 /**
- * Coarsens the hypergraph H and returns a hypergraph HC sequentially.
+ * Contracts all vertices of a distributed hypergraph H that are contained in
+ * exactly the same nets and returns the contracted hypergraph HC. Vertices are
+ * compared using fingerprints sent to the owner of their smallest net.
+ */
+pmondriaan::hypergraph contract_identical_vertices(bulk::world& world,
+                                                   pmondriaan::hypergraph& H,
+                                                   pmondriaan::contraction& C,
+                                                   pmondriaan::options& opts);
+
+/**
+ * Coarsens the hypergraph H and returns a hypergraph HC sequentially. If
+ * same_part, only vertices in the same part are contracted, and the coarsened
+ * vertices keep the part of the vertices they contain.
  */
 pmondriaan::hypergraph coarsen_hypergraph_seq(bulk::world& world,
                                               pmondriaan::hypergraph& H,
                                               pmondriaan::contraction& C,
                                               pmondriaan::options& opts,
-                                              std::mt19937& rng);
+                                              std::mt19937& rng,
+                                              bool same_part = false);
+
+/**
+ * Coarsens the hypergraph H sequentially by contracting all vertices that were
+ * in the same cluster at the given level of the hierarchy of a parent hypergraph.
+ */
+pmondriaan::hypergraph coarsen_hypergraph_projected(bulk::world& world,
+                                                    pmondriaan::hypergraph& H,
+                                                    pmondriaan::contraction& C,
+                                                    pmondriaan::hierarchy& parent,
+                                                    size_t level);
 
 /**
- * Add a copy of a vertex v to a list of vertices.
+ * Add a copy of a vertex v, including its part, to a list of vertices.
  */
 void add_v_to_list(std::vector<pmondriaan::vertex>& v_list, pmondriaan::vertex& v);
 
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+
+#include "hypergraph/hypergraph.hpp"
+#include "options.hpp"
+
+namespace pmondriaan {
+
+/**
+ * Refines a bisection of the hypergraph H with counts C by minimum cuts. A
+ * region of vertices around the cut is grown in both parts, and the rest of
+ * each part is contracted into the source or the sink of a flow network in
+ * which every net is an edge with its cost as capacity. The most balanced of
+ * the minimum cuts closest to the source and to the sink is applied if it
+ * lowers the cutsize and is balanced, which is repeated until the cutsize no
+ * longer improves. The weights of the parts are updated. Returns the cutsize.
+ */
+long flow_refine(pmondriaan::hypergraph& H,
+                 std::vector<std::vector<long>>& C,
+                 std::vector<long>& weights,
+                 long max_weight_0,
+                 long max_weight_1,
+                 pmondriaan::options& opts,
+                 long cut_size);
+
+} // namespace pmondriaan
@@ -1,4 +1,5 @@
 #include <random>
+#include <vector>
 
 #include <bulk/bulk.hpp>
 #ifdef BACKEND_MPI
@@ -8,6 +9,7 @@
 #endif
 
 #include "hypergraph/hypergraph.hpp"
+#include "multilevel_bisect/label_propagation.hpp"
 #include "util/interval.hpp"
 
 namespace pmondriaan {
@@ -21,4 +23,67 @@ long initial_partitioning(pmondriaan::hypergraph& H,
                           pmondriaan::options& opts,
                           std::mt19937& rng);
 
+/**
+ * Creates an initial partitioning for hypergraph H, where the attempts are
+ * divided over all processors. Returns the quality of the solution found by this processor.
+ */
+long initial_partitioning(bulk::world& world,
+                          pmondriaan::hypergraph& H,
+                          long max_weight_0,
+                          long max_weight_1,
+                          pmondriaan::options& opts,
+                          std::mt19937& rng);
+
+/**
+ * Creates an initial partitioning for hypergraph H using the attempts
+ * first, first + step, ... of the attempt budget, which are run concurrently
+ * by opts.threads threads. Returns the quality of the solution found.
+ */
+long initial_partitioning_attempts(pmondriaan::hypergraph& H,
+                                   long max_weight_0,
+                                   long max_weight_1,
+                                   pmondriaan::options& opts,
+                                   std::mt19937& rng,
+                                   long first,
+                                   long step);
+
+/**
+ * Returns the algorithm used in the given attempt.
+ */
+pmondriaan::initial initial_algorithm(pmondriaan::initial mode, long attempt);
+
+/**
+ * Bisects H using the given algorithm, without refinement. Returns the
+ * labels of the vertices and fills C with the counts of the labels for each net.
+ * The label propagation reuses the scratch space if it is given.
+ */
+std::vector<long> initial_bisect(pmondriaan::hypergraph& H,
+                                 std::vector<std::vector<long>>& C,
+                                 pmondriaan::initial algorithm,
+                                 long max_weight_0,
+                                 long max_weight_1,
+                                 pmondriaan::options& opts,
+                                 std::mt19937& rng,
+                                 pmondriaan::lp_bisect_scratch* scratch = nullptr);
+
+/**
+ * Bisects H randomly under the balance constraint. Returns the labels of the vertices.
+ */
+std::vector<long>
+random_bisect(pmondriaan::hypergraph& H, long max_weight_0, long max_weight_1, std::mt19937& rng);
+
+/**
+ * Bisects H by greedy hypergraph growing of part 0 from a random seed vertex,
+ * using the FM gains of the vertices. Returns the labels of the vertices.
+ */
+std::vector<long>
+ghg_bisect(pmondriaan::hypergraph& H, long max_weight_0, long max_weight_1, std::mt19937& rng);
+
+/**
+ * Bisects H by growing part 0 in breadth-first order from a random vertex.
+ * Returns the labels of the vertices.
+ */
+std::vector<long>
+bfs_bisect(pmondriaan::hypergraph& H, long max_weight_0, long max_weight_1, std::mt19937& rng);
+
 } // namespace pmondriaan
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+#else
+#include <bulk/backends/thread/thread.hpp>
+#endif
+
+#include "hypergraph/hypergraph.hpp"
+#include "hypergraph/net_directory.hpp"
+#include "options.hpp"
+
+namespace pmondriaan {
+
+/**
+ * Refines a bisection of the distributed hypergraph H in the style of Jet.
+ * Each iteration selects all vertices whose move loses little, keeps the moves
+ * that still have positive gain assuming all moves with higher priority
+ * happened (the afterburner), and then restores the balance by moving the
+ * vertices with the smallest loss per unit of weight. Returns the cutsize of the
+ * best balanced solution found, which is also the solution H ends in. The net
+ * directory of H is built if it is not given.
+ */
+long jet_refine_par(bulk::world& world,
+                    pmondriaan::hypergraph& H,
+                    std::vector<std::vector<long>>& C,
+                    long weight_0,
+                    long weight_1,
+                    long max_weight_0,
+                    long max_weight_1,
+                    pmondriaan::options& opts,
+                    long cut_size = std::numeric_limits<long>::max(),
+                    pmondriaan::net_directory* directory = nullptr);
+
+} // namespace pmondriaan
@@ -1,7 +1,19 @@
+#pragma once
+
+#include <limits>
 #include <random>
 #include <vector>
 
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+#else
+#include <bulk/backends/thread/thread.hpp>
+#endif
+
 #include "hypergraph/hypergraph.hpp"
+#include "hypergraph/net_directory.hpp"
+#include "options.hpp"
 
 namespace pmondriaan {
 
@@ -12,11 +24,54 @@ namespace pmondriaan {
 std::vector<long>
 label_propagation(pmondriaan::hypergraph& H, long l, long max_iter, long min_size, std::mt19937& rng);
 
+/**
+ * Scratch space of label_propagation_bisect, which can be reused by all calls
+ * on the same hypergraph to avoid allocations and net lookups. It stores the
+ * local indices of the nets of every vertex, the counts of both labels of
+ * every net and the order in which the vertices are visited.
+ */
+struct lp_bisect_scratch {
+    // the nets of vertex i are pins[offsets[i]] upto pins[offsets[i + 1]]
+    std::vector<long> offsets;
+    std::vector<long> pins;
+    std::vector<long> counts;
+    std::vector<long> indices;
+
+    // builds the nets of the vertices of H if needed and clears the counts
+    void prepare(pmondriaan::hypergraph& H);
+};
+
+/**
+ * Bisects H by size-constrained label propagation with at most max_iter
+ * iterations. Returns the labels of the vertices and adds the counts of the
+ * labels of each net to C. The scratch space is reused if it is given.
+ */
 std::vector<long> label_propagation_bisect(pmondriaan::hypergraph& H,
                                            std::vector<std::vector<long>>& C,
                                            long max_iter,
                                            long max_weight_0,
                                            long max_weight_1,
-                                           std::mt19937& rng);
+                                           std::mt19937& rng,
+                                           pmondriaan::lp_bisect_scratch* scratch = nullptr);
+
+/**
+ * Refines a bisection of the distributed hypergraph H by size-constrained
+ * label propagation, using the global counts C of the nets. In each round every
+ * processor moves its vertices with positive gain within its share of a global
+ * budget per direction, after which the counts are synchronized once by the
+ * owners of the nets. Returns the cutsize of the solution found. The net
+ * directory of H is built if it is not given.
+ */
+long label_propagation_refine_par(bulk::world& world,
+                                  pmondriaan::hypergraph& H,
+                                  std::vector<std::vector<long>>& C,
+                                  long weight_0,
+                                  long weight_1,
+                                  long max_weight_0,
+                                  long max_weight_1,
+                                  pmondriaan::options& opts,
+                                  std::mt19937& rng,
+                                  long cut_size = std::numeric_limits<long>::max(),
+                                  pmondriaan::net_directory* directory = nullptr);
 
 } // namespace pmondriaan
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <vector>
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+#else
+#include <bulk/backends/thread/thread.hpp>
+#endif
+
+#include "hypergraph/hypergraph.hpp"
+#include "hypergraph/net_directory.hpp"
+
+namespace pmondriaan {
+
+/**
+ * The global counts C of the nets of a distributed bisection, for the parallel
+ * refinements that move many vertices at once. Vertices are moved using the
+ * local view of the counts, after which the counts are synchronized once
+ * through the processors that own the nets. The net directory of H is built if
+ * it is not given.
+ */
+class parallel_counts {
+  public:
+    parallel_counts(bulk::world& world,
+                    pmondriaan::hypergraph& H,
+                    std::vector<std::vector<long>>& C,
+                    pmondriaan::net_directory* directory = nullptr);
+
+    // moves the vertex with local id i to the other part, returns the change in weight of part 0
+    long move(long i);
+
+    // the gain of moving the vertex with local id i to the other part
+    long gain(long i);
+
+    // the local ids of the vertices in nets that are cut
+    std::vector<long> boundary();
+
+    // sends the changed counts to the owners and receives the new global counts,
+    // returns the new global cutsize and the global change in weight of part 0
+    std::array<long, 2> synchronize(long weight_change);
+
+    // computes the global cutsize
+    long cut_size();
+
+    // the processor responsible for the net with global id n
+    int owner(long n) { return directory_.owner(n); }
+
+  private:
+    bulk::world& world_;
+    pmondriaan::hypergraph& H_;
+    std::vector<std::vector<long>>& C_;
+    std::optional<pmondriaan::net_directory> own_directory_;
+    pmondriaan::net_directory& directory_;
+    std::vector<long> previous_C_;
+    std::vector<long> prev_C_0_;
+    bulk::queue<long, long> update_nets_;
+    long cut_size_my_nets_;
+    pmondriaan::dirty_nets changed_;
+    std::vector<bool> in_boundary_;
+};
+
+} // namespace pmondriaan
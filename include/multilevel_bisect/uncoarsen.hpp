@@ -9,6 +9,7 @@
 
 #include "hypergraph/contraction.hpp"
 #include "hypergraph/hypergraph.hpp"
+#include "multilevel_bisect/KLFM/stopping_rule.hpp"
 #include "multilevel_bisect/sample.hpp"
 
 namespace pmondriaan {
@@ -16,7 +17,8 @@ namespace pmondriaan {
 /**
  * Uncoarsens the hypergraph HC sequentially into the hypergraph H.
  * The cutsize is then optimized using the KLFM algorithm. Returns
- * the cutsize of the partitioning found.
+ * the cutsize of the partitioning found. The KLFM moves are added to stats
+ * if it is not a nullptr.
  */
 long uncoarsen_hypergraph_seq(pmondriaan::hypergraph& HC,
                               pmondriaan::hypergraph& H,
@@ -25,12 +27,14 @@ long uncoarsen_hypergraph_seq(pmondriaan::hypergraph& HC,
                               long max_weight_0,
                               long max_weight_1,
                               long cut_size,
-                              std::mt19937& rng);
+                              std::mt19937& rng,
+                              pmondriaan::KLFM_statistics* stats = nullptr);
 
 /**
  * Uncoarsens the hypergraph HC into the hypergraph H.
  * The cutsize is then optimized using the parallel KLFM algorithm. Returns
- * the cutsize of the partitioning found.
+ * the cutsize of the partitioning found. The local KLFM moves are added to
+ * stats if it is not a nullptr.
  */
 long uncoarsen_hypergraph_par(bulk::world& world,
                               pmondriaan::hypergraph& HC,
@@ -40,7 +44,8 @@ long uncoarsen_hypergraph_par(bulk::world& world,
                               long max_weight_0,
                               long max_weight_1,
                               long cut_size,
-                              std::mt19937& rng);
+                              std::mt19937& rng,
+                              pmondriaan::KLFM_statistics* stats = nullptr);
 
 /**
  * Uncoarsens the hypergraph HC into the hypergraph H.
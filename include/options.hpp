@@ -5,6 +5,8 @@ namespace pmondriaan {
 enum class m : int { cut_net, lambda_minus_one };
 enum class bisection : int { random, multilevel };
 enum class sampling : int { random, label_propagation };
+enum class initial : int { label_propagation, ghg, random, bfs, portfolio };
+enum class refinement : int { klfm, label_propagation, jet };
 /**
  *
  */
@@ -17,6 +19,48 @@ struct options {
     size_t KLFM_max_passes;
     size_t KLFM_max_no_gain_moves;
     size_t KLFM_par_number_send_moves;
+    // reuse the coarsening hierarchy of a bisection for the sequential bisections of its parts
+    bool coarsening_reuse = false;
+    // let idle processors steal sequential bisection jobs from busy processors
+    bool work_stealing = false;
+    // the number of threads per processor used for the sequential bisections and initial partitioning
+    size_t threads = 1;
+    // the algorithm used for the initial partitioning, a portfolio cycles through all of them
+    initial initial_mode = initial::portfolio;
+    // the number of initial partitioning attempts, divided over all processors of a bisection
+    size_t initial_attempts = 10;
+    // the number of attempts without improving a balanced solution after which
+    // the initial partitioning stops, 0 never stops early
+    size_t initial_max_no_improvement = 0;
+    // the refinement used in the parallel uncoarsening on levels with at least
+    // refinement_min_size vertices, smaller levels are refined by parallel KLFM
+    refinement refinement_par = refinement::klfm;
+    size_t refinement_min_size = 0;
+    // a vertex with negative gain is a candidate in the jet refinement if its loss is smaller
+    // than this factor times the cost of its nets that stay connected to its part
+    double jet_negative_gain_factor = 0.25;
+    // the number of jet iterations without finding a better solution after which it stops
+    size_t jet_max_no_improvement = 3;
+    // if true, the nets are divided over the processors such that every processor
+    // is responsible for about the same number of pins instead of the same number of nets
+    bool balance_net_ownership = false;
+    // if true, the k-way partitioning found by recursive bisection is refined by moving
+    // vertices between any two parts, for at most kway_max_rounds rounds
+    bool kway_refinement = false;
+    size_t kway_max_rounds = 16;
+    // if true, the levels of the sequential uncoarsening are refined by minimum cuts before
+    // KLFM, in a region around the cut whose size is scaled by flow_region_factor
+    bool flow_refinement = false;
+    double flow_region_factor = 16.0;
+    // the number of V-cycles that refine every multilevel bisection, no new cycle is started
+    // after vcycle_time_limit milliseconds if it is positive
+    size_t vcycles = 0;
+    double vcycle_time_limit = 0.0;
+    // if true, a KLFM pass stops when a random walk model of the gains since the last
+    // improvement makes a better solution unlikely, instead of after KLFM_max_no_gain_moves
+    // moves, a larger KLFM_stopping_alpha searches longer
+    bool KLFM_adaptive_stopping = false;
+    double KLFM_stopping_alpha = 1.0;
 
     m metric;
     bisection bisection_mode;
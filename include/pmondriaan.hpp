@@ -4,18 +4,27 @@
 #include <bulk/bulk.hpp>
 #include <hypergraph/contraction.hpp>
 #include <hypergraph/hypergraph.hpp>
+#include <hypergraph/net_directory.hpp>
 #include <hypergraph/readhypergraph.hpp>
+#include <hypergraph/replicate.hpp>
+#include <kway_refinement.hpp>
 #include <multilevel_bisect/KLFM/KLFM.hpp>
 #include <multilevel_bisect/KLFM/KLFM_parallel.hpp>
 #include <multilevel_bisect/KLFM/gain_buckets.hpp>
+#include <multilevel_bisect/KLFM/stopping_rule.hpp>
 #include <multilevel_bisect/coarsen.hpp>
+#include <multilevel_bisect/flow_refinement.hpp>
 #include <multilevel_bisect/initial_partitioning.hpp>
+#include <multilevel_bisect/jet.hpp>
 #include <multilevel_bisect/label_propagation.hpp>
+#include <multilevel_bisect/parallel_counts.hpp>
 #include <multilevel_bisect/sample.hpp>
 #include <multilevel_bisect/uncoarsen.hpp>
 #include <options.hpp>
 #include <recursive_bisection.hpp>
 #include <util/interval.hpp>
+#include <util/job_pool.hpp>
+#include <util/max_flow.hpp>
 #include <util/random_hypergraph.hpp>
 #include <util/write_partitioning.hpp>
-#include <work_item.hpp>
\ No newline at end of file
+#include <work_item.hpp>
\ No newline at end of file
@@ -1,25 +1,131 @@
 #pragma once
 
+#include <deque>
+#include <functional>
+#include <random>
+#include <stack>
 #include <stdlib.h>
 #include <string>
 #include <vector>
 
+#include "bisect.hpp"
 #include "hypergraph/hypergraph.hpp"
 #include "options.hpp"
 #include "util/interval.hpp"
+#include "work_item.hpp"
 
 namespace pmondriaan {
 
 /**
- * Recursively bisects a hypergraph into k parts.
+ * A job in a batch of recursive bisections of the same hypergraph.
  */
-void recursive_bisect(bulk::world& world,
+struct batch_job {
+    long k;
+    double epsilon;
+    unsigned int seed;
+};
+
+/**
+ * Recursively bisects a hypergraph into k parts and returns the cutsize of the partitioning.
+ */
+long recursive_bisect(bulk::world& world,
                       pmondriaan::hypergraph& H,
                       long k,
                       double epsilon,
                       double eta,
                       pmondriaan::options opts);
 
+/**
+ * Recursively bisects a hypergraph into k parts. If first_levels is not a
+ * nullptr, the coarsening of the first bisection is taken from it, or stored
+ * in it when it is still empty. Returns the cutsize of the partitioning, which
+ * for the multilevel bisection is the sum of the cutsizes of all bisections.
+ */
+long recursive_bisect(bulk::world& world,
+                      pmondriaan::hypergraph& H,
+                      long k,
+                      double epsilon,
+                      double eta,
+                      pmondriaan::options opts,
+                      std::mt19937& rng,
+                      pmondriaan::coarsening_levels* first_levels);
+
+/**
+ * Recursively bisects a copy of the hypergraph H for each job and passes the
+ * partitioned copy and its cutsize to result. The coarsening of the first
+ * bisection does not depend on k or epsilon, so it is computed once, using the
+ * seed of the first job.
+ */
+void recursive_bisect_batch(bulk::world& world,
+                            const pmondriaan::hypergraph& H,
+                            const std::vector<pmondriaan::batch_job>& jobs,
+                            double eta,
+                            pmondriaan::options opts,
+                            std::function<void(const pmondriaan::batch_job&, pmondriaan::hypergraph&, long)> result);
+
+/**
+ * Bisects a hypergraph, using the coarsening stored in first_levels if it is
+ * not a nullptr and storing the coarsening in it if it is empty.
+ */
+std::vector<long> bisect_cached(bulk::world& world,
+                                pmondriaan::hypergraph& H,
+                                pmondriaan::options& opts,
+                                long max_weight_0,
+                                long max_weight_1,
+                                long start,
+                                long end,
+                                interval labels,
+                                std::mt19937& rng,
+                                pmondriaan::hierarchy& parent,
+                                pmondriaan::hierarchy& hierarchy,
+                                pmondriaan::coarsening_levels* first_levels,
+                                long* bisection_cut = nullptr);
+
+/**
+ * Bisects the sequential jobs of all processors in supersteps of one
+ * bisection each. After every superstep, idle processors steal the oldest job
+ * of the processors with the most remaining work, and the labels of stolen
+ * vertices are sent back to their owner at the end. Returns the sum of the
+ * cutsizes of the bisections done by this processor.
+ */
+long bisect_jobs_stealing(bulk::world& world,
+                          pmondriaan::hypergraph& H,
+                          std::deque<pmondriaan::work_item>& jobs,
+                          pmondriaan::options& opts,
+                          long maxweight,
+                          std::mt19937& rng);
+
+/**
+ * Bisects the sequential jobs of this processor, processing jobs on disjoint
+ * vertex ranges concurrently using a pool of opts.threads threads. If
+ * first_levels is not a nullptr, the first job is bisected before the pool
+ * starts, using the coarsening cached in first_levels. Returns the sum of the
+ * cutsizes of the bisections.
+ */
+long bisect_jobs_threaded(bulk::world& world,
+                          pmondriaan::hypergraph& H,
+                          std::stack<pmondriaan::work_item>& jobs,
+                          pmondriaan::options& opts,
+                          long maxweight,
+                          std::mt19937& rng,
+                          pmondriaan::coarsening_levels* first_levels = nullptr);
+
+/**
+ * Bisects the vertices of a job once and returns the jobs for the parts that
+ * have to be split further, the last one containing part 0. If bisection_cut
+ * is not a nullptr, the cutsize of the bisection is stored in it. The
+ * coarsening cached in first_levels is used if it is not a nullptr.
+ */
+std::vector<pmondriaan::work_item>
+bisect_job(bulk::world& world,
+           pmondriaan::hypergraph& H,
+           pmondriaan::work_item job,
+           pmondriaan::options& opts,
+           long maxweight,
+           std::mt19937& rng,
+           long* bisection_cut = nullptr,
+           pmondriaan::coarsening_levels* first_levels = nullptr);
+
 std::vector<long>
 compute_max_global_weight(long k_, long k_low, long k_high, long weight_mypart, long maxweight);
 
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "work_item.hpp"
+
+namespace pmondriaan {
+
+/**
+ * A pool of threads that processes work_items. Every thread has its own deque
+ * of jobs: new jobs are added to the back of the deque of the thread that
+ * created them, and idle threads steal the oldest job of another thread.
+ */
+class job_pool {
+  public:
+    job_pool(size_t threads)
+    : jobs_(threads), mutexes_(threads), pending_(0) {}
+
+    /**
+     * Adds a job to the deque of the given thread.
+     */
+    void push(size_t thread, pmondriaan::work_item job);
+
+    /**
+     * Runs f(thread, job) for all jobs until no jobs are left, using all threads
+     * of the pool. New jobs may be pushed by f.
+     */
+    void run(std::function<void(size_t, pmondriaan::work_item)> f);
+
+    size_t threads() { return jobs_.size(); }
+
+  private:
+    std::vector<std::deque<pmondriaan::work_item>> jobs_;
+    std::vector<std::mutex> mutexes_;
+    // the number of jobs that have been pushed but are not finished yet
+    std::atomic<long> pending_;
+
+    std::optional<pmondriaan::work_item> pop_(size_t thread);
+    void work_(size_t thread, std::function<void(size_t, pmondriaan::work_item)>& f);
+};
+
+} // namespace pmondriaan
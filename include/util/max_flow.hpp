@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+namespace pmondriaan {
+
+/**
+ * A flow network with integer capacities. The maximum flow is computed with
+ * Dinic's algorithm, after which the minimum cuts closest to the source and
+ * closest to the sink can be read from the residual network.
+ */
+class max_flow {
+  public:
+    max_flow(long nodes) : first_(nodes, -1), level_(nodes), current_(nodes) {}
+
+    // adds an edge from u to v with the given capacity
+    void add_edge(long u, long v, long capacity);
+
+    // computes the maximum flow from s to t
+    long compute(long s, long t);
+
+    // the nodes reachable from s in the residual network, the source side of the
+    // minimum cut closest to s
+    std::vector<bool> reachable_from(long s);
+
+    // the nodes that reach t in the residual network, the sink side of the
+    // minimum cut closest to t
+    std::vector<bool> reaching(long t);
+
+    long nodes() { return first_.size(); }
+
+  private:
+    struct edge {
+        long to;
+        long capacity;
+        long next;
+    };
+
+    // the edges leaving a node form a linked list starting at first_, the
+    // reverse of edge e is edge e ^ 1
+    std::vector<edge> edges_;
+    std::vector<long> first_;
+    std::vector<long> level_;
+    std::vector<long> current_;
+
+    bool build_levels_(long s, long t);
+    long augment_(long s, long t);
+};
+
+} // namespace pmondriaan
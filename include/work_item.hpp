@@ -1,22 +1,33 @@
 #pragma once
 
+#include <memory>
+
+#include "hypergraph/contraction.hpp"
+
 namespace pmondriaan {
 
 /**
  * A work_item stores the start and end location of the vertices to be split and
- * the highest en lowest label to be assigned.
+ * the highest en lowest label to be assigned, and optionally the coarsening
+ * hierarchy of the bisection that created it.
  */
 class work_item {
   public:
-    work_item(long start, long end, long label_low, long label_high, long weight)
+    work_item(long start,
+              long end,
+              long label_low,
+              long label_high,
+              long weight,
+              std::shared_ptr<pmondriaan::hierarchy> hierarchy = nullptr)
     : start_(start), end_(end), label_low_(label_low), label_high_(label_high),
-      weight_(weight) {}
+      weight_(weight), hierarchy_(hierarchy) {}
 
     long start() { return start_; }
     long end() { return end_; }
     long label_low() { return label_low_; }
     long label_high() { return label_high_; }
     long weight() { return weight_; }
+    auto hierarchy() { return hierarchy_; }
 
   private:
     long start_;
@@ -24,7 +35,8 @@ class work_item {
     long label_low_;
     long label_high_;
     long weight_;
+    std::shared_ptr<pmondriaan::hierarchy> hierarchy_;
 };
 
 
-} // namespace pmondriaan
\ No newline at end of file
+} // namespace pmondriaan
\ No newline at end of file
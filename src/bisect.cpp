@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <array>
 #include <limits>
 #include <math.h>
 #include <random>
@@ -7,6 +9,7 @@
 #include "algorithm.hpp"
 #include "bisect.hpp"
 #include "hypergraph/hypergraph.hpp"
+#include "hypergraph/replicate.hpp"
 #include "multilevel_bisect/coarsen.hpp"
 #include "multilevel_bisect/initial_partitioning.hpp"
 #include "multilevel_bisect/uncoarsen.hpp"
@@ -15,9 +18,11 @@
 
 namespace parameters {
 constexpr long stopping_time_par = 3;
+constexpr double min_ratio_projected = 0.05;
 }
 constexpr bool print_time = true;
 constexpr bool simplify_duplicates = true;
+constexpr bool simplify_identical_par = true;
 
 namespace pmondriaan {
 
@@ -33,6 +38,28 @@ std::vector<long> bisect(bulk::world& world,
                          long end,
                          interval labels,
                          std::mt19937& rng) {
+    auto parent = pmondriaan::hierarchy();
+    auto hierarchy = pmondriaan::hierarchy();
+    return bisect(world, H, opts, max_weight_0, max_weight_1, start, end,
+                  labels, rng, parent, hierarchy);
+}
+
+/**
+ * Bisect a hypergraph using the given bisection method and returns the weights
+ * of the two parts, reusing the coarsening hierarchy of a parent bisection.
+ */
+std::vector<long> bisect(bulk::world& world,
+                         pmondriaan::hypergraph& H,
+                         pmondriaan::options& opts,
+                         long max_weight_0,
+                         long max_weight_1,
+                         long start,
+                         long end,
+                         interval labels,
+                         std::mt19937& rng,
+                         pmondriaan::hierarchy& parent,
+                         pmondriaan::hierarchy& hierarchy,
+                         long* bisection_cut) {
 
     auto weight_parts = std::vector<long>(2);
     auto p = world.active_processors();
@@ -42,8 +69,8 @@ std::vector<long> bisect(bulk::world& world,
     }
 
     if (opts.bisection_mode == pmondriaan::bisection::multilevel) {
-        weight_parts = bisect_multilevel(world, H, opts, max_weight_0,
-                                         max_weight_1, start, end, labels, rng);
+        weight_parts = bisect_multilevel(world, H, opts, max_weight_0, max_weight_1, start,
+                                         end, labels, rng, parent, hierarchy, bisection_cut);
     }
 
     return weight_parts;
@@ -90,12 +117,71 @@ std::vector<long> bisect_multilevel(bulk::world& world,
                                     long end,
                                     interval labels,
                                     std::mt19937& rng) {
+    auto parent = pmondriaan::hierarchy();
+    auto hierarchy = pmondriaan::hierarchy();
+    return bisect_multilevel(world, H, opts, max_weight_0, max_weight_1, start,
+                             end, labels, rng, parent, hierarchy);
+}
+
+/**
+ * Bisects a hypergraph using the multilevel framework, reusing the sequential
+ * coarsening hierarchy of a parent bisection.
+ */
+std::vector<long> bisect_multilevel(bulk::world& world,
+                                    pmondriaan::hypergraph& H,
+                                    pmondriaan::options& opts,
+                                    long max_weight_0,
+                                    long max_weight_1,
+                                    long start,
+                                    long end,
+                                    interval labels,
+                                    std::mt19937& rng,
+                                    pmondriaan::hierarchy& parent,
+                                    pmondriaan::hierarchy& hierarchy,
+                                    long* bisection_cut) {
+    auto levels = coarsen_multilevel(world, H, opts, start, end, rng, parent);
+    hierarchy = std::move(levels.hierarchy);
+    long cut = 0;
+    auto weight_parts = uncoarsen_multilevel(world, H, opts, max_weight_0, max_weight_1,
+                                             labels, rng, levels, &cut);
+    weight_parts = vcycle_multilevel(world, H, opts, max_weight_0, max_weight_1, start, end,
+                                     labels, rng, weight_parts, cut);
+    if (bisection_cut != nullptr) {
+        *bisection_cut = cut;
+    }
+    return weight_parts;
+}
+
+/**
+ * Performs the coarsening phase of the multilevel framework on the vertices of
+ * H with indices between start and end, keeping the bisection given by
+ * partition if it is not a nullptr.
+ */
+coarsening_levels coarsen_multilevel(bulk::world& world,
+                                     pmondriaan::hypergraph& H,
+                                     pmondriaan::options& opts,
+                                     long start,
+                                     long end,
+                                     std::mt19937& rng,
+                                     pmondriaan::hierarchy& parent,
+                                     interval* partition) {
 
     // a hypergraph containing only vertices with indices between start and end is created
     auto H_reduced = pmondriaan::create_new_hypergraph(world, H, start, end);
+    auto same_part = (partition != nullptr);
+    if (same_part) {
+        for (auto& v : H_reduced.vertices()) {
+            v.set_part((v.part() == partition->low) ? 0 : 1);
+        }
+    }
 
     // the number of parallel coursenings performed
     size_t nc_par = 0;
+    // the number of parallel coarsening rounds, levels of identical vertices are not counted
+    size_t rounds_par = 0;
+
+    auto hierarchy = pmondriaan::hierarchy();
+    auto shared = std::shared_ptr<pmondriaan::hypergraph>();
 
     auto HC_list = std::vector<pmondriaan::hypergraph>{H_reduced};
     auto C_list = std::vector<pmondriaan::contraction>();
@@ -118,87 +204,96 @@ std::vector<long> bisect_multilevel(bulk::world& world,
 
         double ratio = 1.0;
         while ((HC_list[nc_par].global_size() > coarsening_nrvertices_par) &&
-               (nc_par < opts.coarsening_maxrounds) && ratio > 0.05) {
+               (rounds_par < opts.coarsening_maxrounds) && ratio > 0.05) {
+
+            auto size_before_round = HC_list[nc_par].global_size();
+            // identical vertices can be in different parts of a given bisection
+            if (simplify_identical_par && !same_part) {
+                simplify_duplicate_nets(world, HC_list[nc_par]);
+
+                // identical vertices are contracted in a separate level, which needs no refinement
+                auto C_identical = pmondriaan::contraction();
+                auto HC_identical =
+                contract_identical_vertices(world, HC_list[nc_par], C_identical, opts);
+                if (HC_identical.global_size() < HC_list[nc_par].global_size()) {
+                    C_list.push_back(std::move(C_identical));
+                    HC_list.push_back(std::move(HC_identical));
+                    nc_par++;
+                }
+
+                if (world.rank() == 0) {
+                    if (print_time) {
+                        world.log("s: %d, time in par simplifying identical "
+                                  "nets and vertices: %lf",
+                                  world.rank(), time.get_change());
+                    }
+                    world.log("After simplifying, size is %d (par)",
+                              HC_list[nc_par].global_size());
+                }
+            }
 
             C_list.push_back({});
             HC_list.push_back(coarsen_hypergraph_par(world, HC_list[nc_par],
-                                                     C_list[nc_par + 1], opts, rng));
+                                                     C_list[nc_par + 1], opts, rng, same_part));
 
             nc_par++;
-            ratio =
-            (double)(HC_list[nc_par - 1].global_size() - HC_list[nc_par].global_size()) /
-            (double)HC_list[nc_par - 1].global_size();
+            rounds_par++;
+            ratio = (double)(size_before_round - HC_list[nc_par].global_size()) /
+                    (double)size_before_round;
 
             if (world.rank() == 0) {
                 if (print_time) {
                     world.log("s: %d, time in iteration par coarsening: %lf",
                               world.rank(), time.get_change());
                 }
-                world.log("After iteration %d, size is %d (par)", nc_par,
+                world.log("After iteration %d, size is %d (par)", rounds_par,
                           HC_list[nc_par].global_size());
             }
         }
 
-        // we now communicate the entire hypergraph to all processors using a queue containing id, weight and nets
-        auto vertex_queue = bulk::queue<long, long, long[]>(world);
-        for (auto& v : HC_list[nc_par].vertices()) {
-            for (long t = 0; t < world.rank(); t++) {
-                vertex_queue(t).send(v.id(), v.weight(), v.nets());
-            }
-            for (long t = world.rank() + 1; t < world.active_processors(); t++) {
-                vertex_queue(t).send(v.id(), v.weight(), v.nets());
-            }
-        }
-        // we also communicate the cost of all local nets
-        auto net_cost_queue = bulk::queue<long, long>(world);
-        for (auto& n : HC_list[nc_par].nets()) {
-            for (long t = 0; t < world.rank(); t++) {
-                net_cost_queue(t).send(n.id(), n.cost());
-            }
-            for (long t = world.rank() + 1; t < world.active_processors(); t++) {
-                net_cost_queue(t).send(n.id(), n.cost());
-            }
-        }
-        HC_list.push_back(HC_list[nc_par]);
+        // we now replicate the entire coarsened hypergraph on all processors
+#ifdef BACKEND_MPI
+        HC_list.push_back(pmondriaan::replicate_hypergraph(world, HC_list[nc_par]));
+#else
+        // threads share a single read-only copy, which is only read by the sequential coarsening
+        shared = pmondriaan::replicate_hypergraph_shared(world, HC_list[nc_par]);
+        HC_list.push_back(pmondriaan::hypergraph(0, 0, {}, {}));
+#endif
         C_list.push_back({});
         nc_par++;
-        world.sync();
-
-        if (print_time && (world.rank() == 0)) {
-            world.log("s: %d, time in sending vertices and net costs: %lf",
-                      world.rank(), time.get_change());
-        }
-
-        // the received nets and vertices are added to the coarsened hypergraph
-        for (const auto& [net_id, cost] : net_cost_queue) {
-            HC_list[nc_par].add_net(net_id, std::vector<long>(), cost);
-        }
-        for (const auto& [id, weight, nets] : vertex_queue) {
-            HC_list[nc_par].add_vertex(id, nets, weight);
-            HC_list[nc_par].add_to_nets(HC_list[nc_par].vertices().back());
-        }
 
         if (print_time && (world.rank() == 0)) {
-            world.log("s: %d, time in creating new hypergraph: %lf",
-                      world.rank(), time.get_change());
+            world.log("s: %d, time in replicating hypergraph: %lf", world.rank(),
+                      time.get_change());
         }
     }
 
     time.get();
 
     auto nc_tot = nc_par;
-    auto max_rounds = opts.coarsening_maxrounds;
+    // levels of identical vertices do not count towards the maximum number of rounds
+    auto max_rounds = opts.coarsening_maxrounds + nc_par - rounds_par;
     if (world.active_processors() > 1) {
         max_rounds++;
     }
 
+    // the hierarchy is only reused in sequential bisections, as long as it coarsens enough
+    auto reuse = opts.coarsening_reuse && (world.active_processors() == 1);
+    auto use_parent = reuse;
+
+    // the hypergraph at the given level, which can be the shared replicated hypergraph
+    auto level = [&](size_t i) -> pmondriaan::hypergraph& {
+        return (shared && (i == nc_par)) ? *shared : HC_list[i];
+    };
+
     // SEQUENTIAL COARSENING PHASE
-    while ((HC_list[nc_tot].global_size() > opts.coarsening_nrvertices) &&
+    while ((level(nc_tot).global_size() > opts.coarsening_nrvertices) &&
            (nc_tot < max_rounds)) {
         C_list.push_back({});
         time.get();
 
-        if (simplify_duplicates) {
+        // the duplicate nets of a shared hypergraph have already been simplified
+        if (simplify_duplicates && !(shared && (nc_tot == nc_par))) {
             simplify_duplicate_nets(HC_list[nc_tot]);
             if (world.rank() == 0) {
                 if (print_time) {
@@ -209,8 +304,27 @@ std::vector<long> bisect_multilevel(bulk::world& world,
             }
         }
 
-        HC_list.push_back(coarsen_hypergraph_seq(world, HC_list[nc_tot],
-                                                 C_list[nc_tot + 1], opts, rng));
+        auto projected = false;
+        if (use_parent && (nc_tot < parent.levels())) {
+            auto C = pmondriaan::contraction();
+            auto HC = coarsen_hypergraph_projected(world, HC_list[nc_tot], C, parent, nc_tot);
+            if (HC.global_size() < (1.0 - parameters::min_ratio_projected) *
+                                   HC_list[nc_tot].global_size()) {
+                C_list[nc_tot + 1] = std::move(C);
+                HC_list.push_back(std::move(HC));
+                projected = true;
+            } else {
+                use_parent = false;
+            }
+        }
+
+        if (!projected) {
+            HC_list.push_back(coarsen_hypergraph_seq(world, level(nc_tot),
+                                                     C_list[nc_tot + 1], opts, rng, same_part));
+        }
+        if (reuse) {
+            hierarchy.add_level(C_list[nc_tot + 1]);
+        }
 
         nc_tot++;
         if (world.rank() == 0) {
@@ -218,15 +332,72 @@ std::vector<long> bisect_multilevel(bulk::world& world,
                 world.log("s: %d, time in iteration seq coarsening: %lf",
                           world.rank(), time.get_change());
             }
-            world.log("After iteration %d, size is %d (seq)", nc_tot - 1,
-                      HC_list[nc_tot].global_size());
+            world.log("After iteration %d, size is %d (%s)", nc_tot - 1,
+                      HC_list[nc_tot].global_size(), projected ? "projected" : "seq");
         }
     }
 
-    time.get();
+    // the initial partitioning needs its own copy if the shared hypergraph was not coarsened
+    if (shared && (nc_tot == nc_par)) {
+        HC_list[nc_par] = pmondriaan::hypergraph(*shared);
+        shared.reset();
+    }
+
+    return {std::move(HC_list), std::move(C_list), nc_par, nc_tot, std::move(hierarchy),
+            std::move(shared), same_part};
+}
+
+/**
+ * Performs the initial partitioning and uncoarsening phases of the multilevel
+ * framework on the coarsened hypergraphs in levels and labels the vertices of H.
+ */
+std::vector<long> uncoarsen_multilevel(bulk::world& world,
+                                       pmondriaan::hypergraph& H,
+                                       pmondriaan::options& opts,
+                                       long max_weight_0,
+                                       long max_weight_1,
+                                       interval labels,
+                                       std::mt19937& rng,
+                                       coarsening_levels& levels,
+                                       long* bisection_cut) {
+    auto& HC_list = levels.HC_list;
+    auto& C_list = levels.C_list;
+    auto nc_par = levels.nc_par;
+    auto nc_tot = levels.nc_tot;
+
+    /* The free vertices are only assigned after the refinement, so the other
+       vertices leave room for the heaviest free vertex in part 1 and for up to
+       the same weight of the other free vertices in part 0. Otherwise heavy
+       free vertices may not fit in either part. The global free weight is
+       known on all processors, so they agree on whether room is reserved,
+       and a bisection on one processor does not communicate. */
+    auto max_weight_0_refine = max_weight_0;
+    auto max_weight_1_refine = max_weight_1;
+    if (C_list[0].global_free_weight() > 0) {
+        long heaviest = 0;
+        for (const auto& [id, weight] : C_list[0].free_vertices()) {
+            heaviest = std::max(heaviest, weight);
+        }
+        if (world.active_processors() > 1) {
+            auto heaviest_free = bulk::var<long>(world);
+            heaviest_free = heaviest;
+            heaviest =
+            bulk::foldl(heaviest_free, [](auto& lhs, auto rhs) { lhs = std::max(lhs, rhs); });
+        }
+        max_weight_0_refine -= std::min(heaviest, C_list[0].global_free_weight() - heaviest);
+        max_weight_1_refine -= heaviest;
+    }
+
+    auto time = bulk::util::timer();
     // INITIAL PARTITIONING PHASE
-    auto cut = pmondriaan::initial_partitioning(HC_list[nc_tot], max_weight_0,
-                                                max_weight_1, opts, rng);
+    long cut;
+    if (levels.partitioned) {
+        // the coarsest hypergraph is replicated, so its cutsize is the global cutsize
+        cut = pmondriaan::cutsize(HC_list[nc_tot], opts.metric);
+    } else {
+        cut = pmondriaan::initial_partitioning(world, HC_list[nc_tot], max_weight_0_refine,
+                                               max_weight_1_refine, opts, rng);
+    }
 
     if (world.rank() == 0) {
         if (print_time) {
@@ -236,12 +407,16 @@ std::vector<long> bisect_multilevel(bulk::world& world,
         world.log("s %d: cut after initial partitioning: %d", world.rank(), cut);
     }
 
+    // a shared hypergraph is only uncoarsened by the processor with the best solution
+    auto nc_seq = levels.shared ? nc_par + 1 : nc_par;
+
     // SEQUENTIAL UNCOARSENING PHASE
-    while (nc_tot > nc_par) {
+    while (nc_tot > nc_seq) {
         nc_tot--;
+        auto stats = pmondriaan::KLFM_statistics();
         cut = pmondriaan::uncoarsen_hypergraph_seq(HC_list[nc_tot + 1], HC_list[nc_tot],
-                                                   C_list[nc_tot + 1], opts, max_weight_0,
-                                                   max_weight_1, cut, rng);
+                                                   C_list[nc_tot + 1], opts, max_weight_0_refine,
+                                                   max_weight_1_refine, cut, rng, &stats);
 
         HC_list.pop_back();
         C_list.pop_back();
@@ -251,7 +426,9 @@ std::vector<long> bisect_multilevel(bulk::world& world,
                 world.log("s: %d, time in iteration seq uncoarsening: %lf",
                           world.rank(), time.get_change());
             }
-            world.log("s %d: cut after seq uncoarsening: %d", world.rank(), cut);
+            world.log("s %d: cut after seq uncoarsening: %d, KLFM moves %d of which %d "
+                      "rolled back",
+                      world.rank(), cut, stats.moves, stats.rolled_back);
         }
 
         if (simplify_duplicates) {
@@ -272,12 +449,26 @@ std::vector<long> bisect_multilevel(bulk::world& world,
         // we find the best solution so far of all partitioners
         bulk::var<long> cut_size(world);
         cut_size = cut;
-        if (HC_list[nc_par].weight_part(0) > max_weight_0 ||
-            HC_list[nc_par].weight_part(1) > max_weight_1) {
+        if (HC_list[nc_seq].weight_part(0) > max_weight_0_refine ||
+            HC_list[nc_seq].weight_part(1) > max_weight_1_refine) {
             cut_size = std::numeric_limits<long>::max();
         }
         auto best_proc = pmondriaan::owner_min(cut_size);
 
+        if (levels.shared) {
+            if (world.rank() == best_proc) {
+                HC_list[nc_par] = pmondriaan::hypergraph(*levels.shared);
+                cut = pmondriaan::uncoarsen_hypergraph_seq(HC_list[nc_par + 1], HC_list[nc_par],
+                                                           C_list[nc_par + 1], opts,
+                                                           max_weight_0_refine,
+                                                           max_weight_1_refine, cut, rng);
+                HC_list[nc_par].reset_duplicate_nets();
+            }
+            HC_list.pop_back();
+            C_list.pop_back();
+            levels.shared.reset();
+        }
+
         // the processor that has found the best solution now sends the labels to all others
         auto label_queue = bulk::queue<long, long>(world);
         if (world.rank() == best_proc) {
@@ -305,21 +496,40 @@ std::vector<long> bisect_multilevel(bulk::world& world,
         time.get();
         while (nc_par > 0) {
             nc_par--;
+            auto stats = pmondriaan::KLFM_statistics();
             cut = pmondriaan::uncoarsen_hypergraph_par(world, HC_list[nc_par + 1],
                                                        HC_list[nc_par],
-                                                       C_list[nc_par + 1], opts, max_weight_0,
-                                                       max_weight_1, cut, rng);
+                                                       C_list[nc_par + 1], opts,
+                                                       max_weight_0_refine,
+                                                       max_weight_1_refine, cut, rng, &stats);
 
             HC_list.pop_back();
             C_list.pop_back();
 
-            if (world.rank() == 0) {
-                if (print_time) {
-                    world.log("s: %d, time in iteration par uncoarsening: %lf",
-                              world.rank(), time.get_change());
+            if (print_time && (world.rank() == 0)) {
+                world.log("s: %d, time in iteration par uncoarsening: %lf", world.rank(),
+                          time.get_change());
+            }
+            // the statistics are only summed over the processors if they are logged
+            if (print_time || opts.KLFM_adaptive_stopping) {
+                auto totals = std::array<long, 2>{0, 0};
+                for (const auto& local : bulk::gather_all(
+                     world, std::array<long, 2>{stats.moves, stats.rolled_back})) {
+                    totals[0] += local[0];
+                    totals[1] += local[1];
+                }
+                if (world.rank() == 0) {
+                    world.log("s %d: cut after par uncoarsening: %d, KLFM moves %d of which %d "
+                              "rolled back",
+                              world.rank(), cut, totals[0], totals[1]);
                 }
+            } else if (world.rank() == 0) {
                 world.log("s %d: cut after par uncoarsening: %d", world.rank(), cut);
             }
+
+            if (simplify_identical_par) {
+                HC_list[nc_par].reset_duplicate_nets();
+            }
         }
     }
 
@@ -334,10 +544,72 @@ std::vector<long> bisect_multilevel(bulk::world& world,
         H(H.local_id(v.id())).set_part(labels(v.part()));
     }
 
+    if (bisection_cut != nullptr) {
+        *bisection_cut = cut;
+    }
+
     auto weight_parts = std::vector<long>(2);
     weight_parts[0] = HC_list[0].weight_part(0);
     weight_parts[1] = HC_list[0].weight_part(1);
     return weight_parts;
 }
 
+/**
+ * Improves the multilevel bisection of the vertices of H with indices between
+ * start and end by V-cycles, updating cut_size. Returns the weights of the two parts.
+ */
+std::vector<long> vcycle_multilevel(bulk::world& world,
+                                    pmondriaan::hypergraph& H,
+                                    pmondriaan::options& opts,
+                                    long max_weight_0,
+                                    long max_weight_1,
+                                    long start,
+                                    long end,
+                                    interval labels,
+                                    std::mt19937& rng,
+                                    std::vector<long> weight_parts,
+                                    long& cut_size) {
+    if (opts.vcycles == 0) {
+        return weight_parts;
+    }
+    auto time = bulk::util::timer();
+    auto parts = std::vector<long>(end - start);
+
+    for (auto cycle = 0u; cycle < opts.vcycles; cycle++) {
+        for (auto i = start; i < end; i++) {
+            parts[i - start] = H(i).part();
+        }
+
+        // the hierarchy of the first coarsening is not projected, as it ignores the parts
+        auto parent = pmondriaan::hierarchy();
+        auto levels = coarsen_multilevel(world, H, opts, start, end, rng, parent, &labels);
+        long cut = 0;
+        auto new_weight_parts = uncoarsen_multilevel(world, H, opts, max_weight_0, max_weight_1,
+                                                     labels, rng, levels, &cut);
+        if (cut >= cut_size) {
+            for (auto i = start; i < end; i++) {
+                H(i).set_part(parts[i - start]);
+            }
+            break;
+        }
+        cut_size = cut;
+        weight_parts = new_weight_parts;
+
+        if (opts.vcycle_time_limit > 0.0) {
+            // all processors need to agree on whether to start another cycle
+            auto max_elapsed = time.get();
+            if (world.active_processors() > 1) {
+                auto elapsed = bulk::var<double>(world);
+                elapsed = max_elapsed;
+                max_elapsed =
+                bulk::foldl(elapsed, [](auto& lhs, auto rhs) { lhs = std::max(lhs, rhs); });
+            }
+            if (max_elapsed > opts.vcycle_time_limit) {
+                break;
+            }
+        }
+    }
+    return weight_parts;
+}
+
 } // namespace pmondriaan
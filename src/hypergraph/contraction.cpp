@@ -175,4 +175,23 @@ void contraction::assign_free_vertices_(pmondriaan::hypergraph& H,
     }
 }
 
+void hierarchy::add_level(pmondriaan::contraction& C) {
+    levels_.push_back(std::unordered_map<long, long>());
+    for (auto i = 0u; i < C.size(); i++) {
+        for (auto match : C.matches(i)) {
+            levels_.back()[match.id()] = C.id_sample(i);
+        }
+    }
+}
+
+long hierarchy::representative(long id, size_t level) {
+    for (auto l = 0u; l <= level; l++) {
+        auto rep = levels_[l].find(id);
+        if (rep != levels_[l].end()) {
+            id = rep->second;
+        }
+    }
+    return id;
+}
+
 } // namespace pmondriaan
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <random>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <bulk/bulk.hpp>
@@ -12,6 +13,7 @@
 #endif
 
 #include "hypergraph/hypergraph.hpp"
+#include "hypergraph/net_directory.hpp"
 
 #include "algorithm.hpp"
 #include "options.hpp"
@@ -128,6 +130,7 @@ void hypergraph::reset_duplicate_nets() {
         long new_cost = net(duplicate.second).cost() - duplicate.first.cost();
         net(duplicate.second).set_cost(new_cost);
     }
+    duplicate_nets_.clear();
 }
 
 // sorts the vertices in the nets on their value
@@ -202,7 +205,8 @@ void hypergraph::move(long id, std::vector<std::vector<long>>& C) {
 
 void hypergraph::move(long id,
                       std::vector<std::vector<long>>& C,
-                      std::vector<std::vector<long>>& C_loc) {
+                      std::vector<std::vector<long>>& C_loc,
+                      pmondriaan::dirty_nets* changed) {
     auto& v = vertices_[this->local_id(id)];
     long from = v.part();
     move_sorted(id, C_loc);
@@ -212,6 +216,9 @@ void hypergraph::move(long id,
         C[local_id_net(n)][to]++;
         C_loc[local_id_net(n)][from]--;
         C_loc[local_id_net(n)][to]++;
+        if (changed != nullptr) {
+            changed->insert(local_id_net(n));
+        }
     }
 }
 
@@ -222,6 +229,16 @@ void hypergraph::update_map() {
     }
 }
 
+/**
+ * Updates the map for the vertices with local id between start and end. No
+ * entries are added, so different ranges can be updated concurrently.
+ */
+void hypergraph::update_map(long start, long end) {
+    for (auto i = start; i < end; i++) {
+        global_to_local.find(vertices_[i].id())->second = i;
+    }
+}
+
 void hypergraph::update_map_nets() {
     net_global_to_local.clear();
     for (auto i = 0u; i < nets_.size(); i++) {
@@ -295,43 +312,44 @@ std::vector<std::vector<long>> init_counts(pmondriaan::hypergraph& H) {
  * Initialize the counts for parts 0,1 for a parallel hypergraph.
  */
 std::vector<std::vector<long>> init_counts(bulk::world& world, pmondriaan::hypergraph& H) {
-    auto s = world.rank();
+    auto directory = pmondriaan::net_directory(world, H);
+    return init_counts(world, H, directory);
+}
 
-    auto local_counts = init_counts(H);
-    auto net_partition =
-    bulk::block_partitioning<1>({H.global_number_nets()},
-                                {(size_t)world.active_processors()});
-    auto count_queue = bulk::queue<long, long>(world);
+/**
+ * Initialize the counts for parts 0,1 for a parallel hypergraph using its net directory.
+ */
+std::vector<std::vector<long>>
+init_counts(bulk::world& world, pmondriaan::hypergraph& H, pmondriaan::net_directory& directory) {
+    auto counts = init_counts(H);
+    auto count_queue = pmondriaan::batched_queue<long>(world);
     // We send all counts of part 0 that are greater than 0 to the responsible processor
-    for (auto i = 0u; i < local_counts.size(); i++) {
-        if (local_counts[i][0] > 0) {
+    for (auto i = 0u; i < counts.size(); i++) {
+        if (counts[i][0] > 0) {
             auto global_id = H.global_id_net(i);
-            count_queue(net_partition.owner(global_id)).send(global_id, local_counts[i][0]);
+            count_queue.send(directory.owner(global_id), global_id, counts[i][0]);
         }
     }
-    world.sync();
+    count_queue.sync();
 
-    auto C_my_nets = bulk::coarray<long>(world, net_partition.local_count(s));
-    for (auto i = 0u; i < net_partition.local_count(s); i++) {
-        C_my_nets[i] = 0;
-    }
-    for (const auto& [net, count] : count_queue) {
-        C_my_nets[net_partition.local(net)[0]] += count;
+    auto C_my_nets = std::vector<long>(directory.local_count(), 0);
+    for (const auto& [net, count] : count_queue.received()) {
+        C_my_nets[directory.local(net)] += count;
     }
 
-    // We get the correct values for the needed counts
-    auto future_counts = std::vector<bulk::future<long>>();
-    for (auto i = 0u; i < local_counts.size(); i++) {
-        auto net = H.nets()[i].id();
-        future_counts.push_back(
-        C_my_nets(net_partition.owner(net))[net_partition.local(net)[0]].get());
+    // The responsible processor sends the counts to the processors holding pins of the net
+    for (auto i = 0u; i < directory.local_count(); i++) {
+        for (auto t : directory.procs(i)) {
+            count_queue.send(t, directory.global(i), C_my_nets[i]);
+        }
     }
-    world.sync();
-    for (auto i = 0u; i < local_counts.size(); i++) {
-        local_counts[i][0] = future_counts[i].value();
-        local_counts[i][1] = (long)H.nets()[i].global_size() - future_counts[i].value();
+    count_queue.sync();
+    for (const auto& [net, count] : count_queue.received()) {
+        auto i = H.local_id_net(net);
+        counts[i][0] = count;
+        counts[i][1] = (long)H.nets()[i].global_size() - count;
     }
-    return local_counts;
+    return counts;
 }
 
 /**
@@ -406,97 +424,145 @@ double load_balance(bulk::world& world, pmondriaan::hypergraph& H, long k) {
 }
 
 /**
- * Compute the cutsize with the correct metric of a local hypergraph
+ * The contribution to the cutsize of a net with the given cost that is present in lambda parts.
  */
-long cutsize(pmondriaan::hypergraph& H, pmondriaan::m metric) {
-    long result = 0;
+long cutsize_net(long lambda, long cost, pmondriaan::m metric) {
     switch (metric) {
-    case pmondriaan::m::cut_net: {
-        for (auto& net : H.nets()) {
-            auto labels_net = std::unordered_set<long>();
-            for (auto& v : net.vertices()) {
-                labels_net.insert(H(H.local_id(v)).part());
-            }
-            if (labels_net.size() > 1) {
-                result += net.cost();
-            }
-        }
-        break;
+    case pmondriaan::m::cut_net: return cutsize_net<pmondriaan::m::cut_net>(lambda, cost);
+    case pmondriaan::m::lambda_minus_one:
+        return cutsize_net<pmondriaan::m::lambda_minus_one>(lambda, cost);
+    default: {
+        std::cerr << "Error: unknown metric\n";
+        return 0;
     }
-    case pmondriaan::m::lambda_minus_one: {
-        for (auto& net : H.nets()) {
-            auto labels_net = std::unordered_set<long>();
-            for (auto& v : net.vertices()) {
-                labels_net.insert(H(H.local_id(v)).part());
-            }
-            if (labels_net.size() > 1) {
-                result += (labels_net.size() - 1) * net.cost();
-            }
+    }
+}
+
+namespace {
+
+/**
+ * Stores the sorted distinct parts of the vertices of a net in parts.
+ */
+void parts_net(pmondriaan::hypergraph& H, pmondriaan::net& net, std::vector<long>& parts) {
+    parts.clear();
+    for (auto v : net.vertices()) {
+        parts.push_back(H(H.local_id(v)).part());
+    }
+    std::sort(parts.begin(), parts.end());
+    parts.erase(std::unique(parts.begin(), parts.end()), parts.end());
+}
+
+/**
+ * Compute the cutsize of the nets a processor is responsible for, from the
+ * (index of the net, part) pairs received for these nets.
+ */
+template <pmondriaan::m metric>
+long cutsize_my_nets(std::vector<std::pair<long, long>>& parts_nets,
+                     std::vector<long>& cost_nets) {
+    std::sort(parts_nets.begin(), parts_nets.end());
+    parts_nets.erase(std::unique(parts_nets.begin(), parts_nets.end()), parts_nets.end());
+    long result = 0;
+    auto i = 0u;
+    while (i < parts_nets.size()) {
+        auto j = i;
+        while ((j < parts_nets.size()) && (parts_nets[j].first == parts_nets[i].first)) {
+            j++;
         }
-        break;
+        result += cutsize_net<metric>(j - i, cost_nets[parts_nets[i].first]);
+        i = j;
     }
-    default: {
-        std::cerr << "Error: unknown metric\n";
-        break;
+    return result;
+}
+
+long cutsize_my_nets(std::vector<std::pair<long, long>>& parts_nets,
+                     std::vector<long>& cost_nets,
+                     pmondriaan::m metric) {
+    if (metric == pmondriaan::m::cut_net) {
+        return cutsize_my_nets<pmondriaan::m::cut_net>(parts_nets, cost_nets);
     }
+    return cutsize_my_nets<pmondriaan::m::lambda_minus_one>(parts_nets, cost_nets);
+}
+
+template <pmondriaan::m metric>
+long cutsize_local(pmondriaan::hypergraph& H) {
+    long result = 0;
+    auto parts = std::vector<long>();
+    for (auto& net : H.nets()) {
+        parts_net(H, net, parts);
+        result += cutsize_net<metric>(parts.size(), net.cost());
     }
     return result;
 }
 
+} // namespace
+
+/**
+ * Compute the cutsize with the correct metric of a local hypergraph
+ */
+long cutsize(pmondriaan::hypergraph& H, pmondriaan::m metric) {
+    if (metric == pmondriaan::m::cut_net) {
+        return cutsize_local<pmondriaan::m::cut_net>(H);
+    }
+    return cutsize_local<pmondriaan::m::lambda_minus_one>(H);
+}
+
 /**
  * Compute the cutsize with the correct metric
  */
 long cutsize(bulk::world& world, pmondriaan::hypergraph& H, pmondriaan::m metric) {
-    long result = 0;
     auto net_partition =
     bulk::block_partitioning<1>({H.global_number_nets()},
                                 {(size_t)world.active_processors()});
 
     // this queue contains all labels present for each net and its cost
     auto labels = bulk::queue<long, long[], long>(world);
+    auto parts = std::vector<long>();
     for (auto& net : H.nets()) {
-        auto labels_net = std::unordered_set<long>();
-        for (auto& v : net.vertices()) {
-            labels_net.insert(H(H.local_id(v)).part());
-        }
-        labels(net_partition.owner(net.id()))
-        .send(net.id(), std::vector<long>(labels_net.begin(), labels_net.end()),
-              net.cost());
+        parts_net(H, net, parts);
+        labels(net_partition.owner(net.id())).send(net.id(), parts, net.cost());
     }
     world.sync();
 
-    auto total_cut =
-    std::vector<std::unordered_set<long>>(net_partition.local_size(world.rank())[0]);
+    auto parts_nets = std::vector<std::pair<long, long>>();
     auto cost_nets = std::vector<long>(net_partition.local_size(world.rank())[0], 0);
     for (const auto& [net, labels_net, cost] : labels) {
-        cost_nets[net_partition.local({(size_t)net})[0]] = cost;
+        auto local = (long)net_partition.local({(size_t)net})[0];
+        cost_nets[local] = cost;
         for (auto l : labels_net) {
-            total_cut[net_partition.local({(size_t)net})[0]].insert(l);
+            parts_nets.emplace_back(local, l);
         }
     }
+    return bulk::sum(world, cutsize_my_nets(parts_nets, cost_nets, metric));
+}
 
-    switch (metric) {
-    case pmondriaan::m::cut_net: {
-        for (auto i = 0u; i < total_cut.size(); i++) {
-            if (total_cut[i].size() > 1) {
-                result += cost_nets[i];
-            }
-        }
-        break;
-    }
-    case pmondriaan::m::lambda_minus_one: {
-        for (auto i = 0u; i < total_cut.size(); i++) {
-            if (total_cut[i].size() > 1) {
-                result += (total_cut[i].size() - 1) * cost_nets[i];
-            }
-        }
-        break;
+/**
+ * Compute the cutsize with the correct metric using the net directory, the
+ * costs of the nets are known by their owners and do not have to be sent
+ */
+long cutsize(bulk::world& world,
+             pmondriaan::hypergraph& H,
+             pmondriaan::m metric,
+             pmondriaan::net_directory& directory) {
+    // this queue contains all labels present for each net
+    auto labels = bulk::queue<long, long[]>(world);
+    auto parts = std::vector<long>();
+    for (auto& net : H.nets()) {
+        parts_net(H, net, parts);
+        labels(directory.owner(net.id())).send(net.id(), parts);
     }
-    default: {
-        std::cerr << "Error: unknown metric\n";
+    world.sync();
+
+    auto parts_nets = std::vector<std::pair<long, long>>();
+    auto cost_nets = std::vector<long>(directory.local_count());
+    for (auto i = 0u; i < directory.local_count(); i++) {
+        cost_nets[i] = directory.cost(i);
     }
+    for (const auto& [net, labels_net] : labels) {
+        for (auto l : labels_net) {
+            parts_nets.emplace_back(directory.local(net), l);
+        }
     }
-    return bulk::sum(world, result);
+    return bulk::sum(world, cutsize_my_nets(parts_nets, cost_nets, metric));
 }
 
 /**
@@ -516,41 +582,26 @@ long cutsize(pmondriaan::hypergraph& H, std::vector<std::vector<long>>& C) {
  * Compute the global net sizes of a hypergraph.
  */
 std::vector<size_t> global_net_sizes(bulk::world& world, pmondriaan::hypergraph& H) {
+    auto directory = pmondriaan::net_directory(world, H);
+    return global_net_sizes(world, H, directory);
+}
 
-    auto net_partition =
-    bulk::block_partitioning<1>({H.global_number_nets()},
-                                {(size_t)world.active_processors()});
-
-    auto nets = H.nets();
-    bulk::queue<long, size_t> net_size_queue(world);
-
-    for (auto i = 0u; i < nets.size(); i++) {
-        net_size_queue(net_partition.owner(nets[i].id()))
-        .send(nets[i].id(), nets[i].size());
-    }
-    world.sync();
-
-    auto size_nets = std::vector<size_t>(net_partition.local_count(world.rank()), 0);
-
-    for (const auto& [id, size] : net_size_queue) {
-        auto local_id = net_partition.local({(size_t)id})[0];
-        size_nets[local_id] += size;
-    }
-
-    for (auto i = 0u; i < size_nets.size(); i++) {
-        if (size_nets[i] > 0) {
-            for (int t = 0; t < world.active_processors(); t++) {
-                net_size_queue(t).send(net_partition.global(i, world.rank())[0],
-                                       size_nets[i]);
-            }
+/**
+ * Compute the global net sizes of a hypergraph using its net directory, only
+ * the processors holding pins of a net receive its size.
+ */
+std::vector<size_t>
+global_net_sizes(bulk::world& world, pmondriaan::hypergraph& H, pmondriaan::net_directory& directory) {
+    auto net_size_queue = pmondriaan::batched_queue<size_t>(world);
+    for (auto i = 0u; i < directory.local_count(); i++) {
+        for (auto t : directory.procs(i)) {
+            net_size_queue.send(t, directory.global(i), directory.global_size(i));
         }
     }
-    world.sync();
-    auto result = std::vector<size_t>(nets.size(), 0);
-    for (const auto& [id, size] : net_size_queue) {
-        if (H.is_local_net(id)) {
-            result[H.local_id_net(id)] = size;
-        }
+    net_size_queue.sync();
+    auto result = std::vector<size_t>(H.nets().size(), 0);
+    for (const auto& [id, size] : net_size_queue.received()) {
+        result[H.local_id_net(id)] = size;
     }
     H.set_global_net_sizes(result);
     return result;
@@ -619,6 +670,88 @@ void simplify_duplicate_nets(pmondriaan::hypergraph& H) {
     }
 }
 
+/**
+ * Simplifies all duplicate nets for a distributed hypergraph.
+ */
+void simplify_duplicate_nets(bulk::world& world, pmondriaan::hypergraph& H) {
+    auto s = world.rank();
+    auto p = world.active_processors();
+    auto net_partition =
+    bulk::block_partitioning<1>({H.global_number_nets()}, {(size_t)p});
+
+    // we send the fingerprints and size of the local part of each net to the owner of the net
+    auto partial_queue = bulk::queue<long, size_t, size_t, long, int>(world);
+    for (auto& n : H.nets()) {
+        size_t fingerprint = 0;
+        size_t fingerprint_2 = 0;
+        for (auto v : n.vertices()) {
+            fingerprint += hash_id(v);
+            fingerprint_2 += hash_id_2(v);
+        }
+        partial_queue(net_partition.owner(n.id()))
+        .send(n.id(), fingerprint, fingerprint_2, (long)n.size(), s);
+    }
+    world.sync();
+
+    auto local_count = net_partition.local_count(s);
+    auto fingerprints = std::vector<size_t>(local_count, 0);
+    auto fingerprints_2 = std::vector<size_t>(local_count, 0);
+    auto sizes = std::vector<long>(local_count, 0);
+    auto procs = std::vector<std::vector<int>>(local_count);
+    for (const auto& [id, fingerprint, fingerprint_2, size, t] : partial_queue) {
+        auto local = net_partition.local(id)[0];
+        fingerprints[local] += fingerprint;
+        fingerprints_2[local] += fingerprint_2;
+        sizes[local] += size;
+        procs[local].push_back(t);
+    }
+
+    // nets with the same fingerprint are collected by the processor owning that fingerprint
+    auto fingerprint_queue = bulk::queue<size_t, size_t, long, long, int[]>(world);
+    for (auto i = 0u; i < local_count; i++) {
+        if (!procs[i].empty()) {
+            fingerprint_queue(fingerprints[i] % p)
+            .send(fingerprints[i], fingerprints_2[i], sizes[i], net_partition.global(i, s)[0],
+                  procs[i]);
+        }
+    }
+    world.sync();
+
+    auto candidates = std::vector<std::tuple<size_t, size_t, long, long, long>>();
+    auto candidate_procs = std::vector<std::vector<int>>();
+    for (const auto& [fingerprint, fingerprint_2, size, id, procs_net] : fingerprint_queue) {
+        candidates.push_back(
+        std::make_tuple(fingerprint, fingerprint_2, size, id, (long)candidate_procs.size()));
+        candidate_procs.push_back(procs_net);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    // nets are only duplicates if both fingerprints and the size match, the net with the
+    // lowest id is kept and all processors holding a duplicate are informed
+    auto duplicate_queue = bulk::queue<long, long>(world);
+    auto first = 0u;
+    for (auto i = 1u; i < candidates.size(); i++) {
+        if ((std::get<0>(candidates[i]) != std::get<0>(candidates[first])) ||
+            (std::get<1>(candidates[i]) != std::get<1>(candidates[first])) ||
+            (std::get<2>(candidates[i]) != std::get<2>(candidates[first]))) {
+            first = i;
+            continue;
+        }
+        auto id = std::get<3>(candidates[i]);
+        auto duplicate_id = std::get<3>(candidates[first]);
+        for (auto t : candidate_procs[std::get<4>(candidates[i])]) {
+            duplicate_queue(t).send(id, duplicate_id);
+        }
+    }
+    world.sync();
+
+    for (const auto& [id, duplicate_id] : duplicate_queue) {
+        auto& duplicate = H.net(duplicate_id);
+        duplicate.set_cost(duplicate.cost() + H.net(id).cost());
+        H.remove_duplicate_net(id, duplicate_id);
+    }
+}
+
 /**
  * Creates a new hypergraph that only contains the vertices of H with local id between start and end.
  */
@@ -638,7 +771,15 @@ create_new_hypergraph(bulk::world& new_world, pmondriaan::hypergraph& H, long st
         }
     }
 
+    // a sequential hypergraph is created without communication, so this can be done concurrently
     auto new_size = new_vertices.size();
+    if (new_world.active_processors() == 1) {
+        auto new_H = pmondriaan::hypergraph(new_size, H.global_number_nets(),
+                                            new_vertices, new_nets);
+        remove_free_nets(new_H, 1);
+        return new_H;
+    }
+
     auto new_global_size = bulk::sum(new_world, new_size);
     auto new_H = pmondriaan::hypergraph(new_global_size, H.global_number_nets(),
                                         new_vertices, new_nets);
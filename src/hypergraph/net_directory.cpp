@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <vector>
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+#else
+#include <bulk/backends/thread/thread.hpp>
+#endif
+
+#include "hypergraph/hypergraph.hpp"
+#include "hypergraph/net_directory.hpp"
+
+namespace pmondriaan {
+
+net_directory::net_directory(bulk::world& world, pmondriaan::hypergraph& H, bool balanced)
+: rank_(world.rank()) {
+    auto p = world.active_processors();
+    auto nr_nets = (long)H.global_number_nets();
+    begin_ = std::vector<long>(p + 1, nr_nets);
+
+    if (!balanced || (nr_nets == 0)) {
+        auto block_size = std::max(1l, (nr_nets + p - 1) / p);
+        for (auto t = 0; t < p; t++) {
+            begin_[t] = std::min(nr_nets, t * block_size);
+        }
+    } else {
+        // processor 0 collects the number of pins in ranges of net ids and
+        // divides the ranges over the processors
+        auto nr_ranges = std::min(nr_nets, 32l * p);
+        auto range = [&](long n) { return (n * nr_ranges) / nr_nets; };
+        auto range_begin = [&](long r) { return ((r * nr_nets) + nr_ranges - 1) / nr_ranges; };
+        auto pins = std::vector<long>(nr_ranges, 0);
+        for (const auto& net : H.nets()) {
+            pins[range(net.id())] += net.size();
+        }
+        auto pins_queue = bulk::queue<long, long>(world);
+        for (auto r = 0; r < nr_ranges; r++) {
+            if (pins[r] > 0) {
+                pins_queue(0).send(r, pins[r]);
+            }
+        }
+        world.sync();
+
+        auto begin_queue = bulk::queue<long[]>(world);
+        if (rank_ == 0) {
+            std::fill(pins.begin(), pins.end(), 0);
+            long total = 0;
+            for (const auto& [r, pins_range] : pins_queue) {
+                pins[r] += pins_range;
+                total += pins_range;
+            }
+            begin_[0] = 0;
+            auto next = 1;
+            long cumulative = 0;
+            for (auto r = 0; r < nr_ranges; r++) {
+                cumulative += pins[r];
+                while ((next < p) && (cumulative * p >= next * total)) {
+                    begin_[next] = range_begin(r + 1);
+                    next++;
+                }
+            }
+            for (auto t = 0; t < p; t++) {
+                begin_queue(t).send(begin_);
+            }
+        }
+        world.sync();
+        for (const auto& begin : begin_queue) {
+            begin_ = begin;
+        }
+    }
+
+    // every processor tells the owners of its nets the cost and the size of its part of the net
+    auto count = local_count();
+    cost_ = std::vector<long>(count, 0);
+    global_size_ = std::vector<size_t>(count, 0);
+    procs_ = std::vector<std::vector<int>>(count);
+    auto info_queue = bulk::queue<long, long, long, int>(world);
+    for (const auto& net : H.nets()) {
+        info_queue(owner(net.id())).send(net.id(), net.cost(), (long)net.size(), rank_);
+    }
+    world.sync();
+    for (const auto& [n, cost, size, t] : info_queue) {
+        auto index = n - begin_[rank_];
+        cost_[index] = cost;
+        global_size_[index] += size;
+        procs_[index].push_back(t);
+    }
+}
+
+} // namespace pmondriaan
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+#else
+#include <bulk/backends/thread/thread.hpp>
+#endif
+
+#include "hypergraph/hypergraph.hpp"
+#include "hypergraph/replicate.hpp"
+
+namespace pmondriaan {
+
+/**
+ * Serializes the vertices of H as a sequence of id, weight, part, degree and nets per vertex.
+ */
+std::vector<long> serialize_vertices(pmondriaan::hypergraph& H) {
+    auto data = std::vector<long>();
+    for (auto& v : H.vertices()) {
+        data.push_back(v.id());
+        data.push_back(v.weight());
+        data.push_back(v.part());
+        data.push_back((long)v.degree());
+        data.insert(data.end(), v.nets().begin(), v.nets().end());
+    }
+    return data;
+}
+
+/**
+ * Returns a hypergraph containing all vertices and nets of the distributed
+ * hypergraph H on every processor.
+ */
+pmondriaan::hypergraph replicate_hypergraph(bulk::world& world, pmondriaan::hypergraph& H) {
+    long s = world.rank();
+    long p = world.active_processors();
+
+    // blocks[i] contains the serialized vertices of processor (s + i) mod p
+    auto blocks = std::vector<std::vector<long>>();
+    blocks.push_back(serialize_vertices(H));
+    // the costs of the nets of all blocks, every net is stored only once
+    auto costs = std::unordered_map<long, long>();
+    for (const auto& n : H.nets()) {
+        costs[n.id()] = n.cost();
+    }
+
+    // in the round with distance d, processor s receives the blocks of
+    // processors s + d upto s + 2d - 1 from processor s + d
+    auto block_queue = bulk::queue<long, long[]>(world);
+    auto cost_queue = bulk::queue<long[], long[]>(world);
+    for (long d = 1; d < p; d *= 2) {
+        auto t = (s - d + p) % p;
+        auto nr_blocks = std::min(d, p - d);
+        for (long i = 0; i < nr_blocks; i++) {
+            block_queue(t).send(i, blocks[i]);
+        }
+        auto net_ids = std::vector<long>();
+        auto net_costs = std::vector<long>();
+        net_ids.reserve(costs.size());
+        net_costs.reserve(costs.size());
+        for (const auto& [id, cost] : costs) {
+            net_ids.push_back(id);
+            net_costs.push_back(cost);
+        }
+        cost_queue(t).send(net_ids, net_costs);
+        world.sync();
+
+        blocks.resize(d + nr_blocks);
+        for (const auto& [i, data] : block_queue) {
+            blocks[d + i] = data;
+        }
+        for (const auto& [ids, received_costs] : cost_queue) {
+            for (auto j = 0u; j < ids.size(); j++) {
+                costs[ids[j]] = received_costs[j];
+            }
+        }
+    }
+
+    // the local nets keep their order, the other nets are sorted on their id
+    auto nets = std::vector<pmondriaan::net>();
+    auto net_index = std::unordered_map<long, long>();
+    for (const auto& n : H.nets()) {
+        net_index[n.id()] = (long)nets.size();
+        nets.push_back(pmondriaan::net(n.id(), std::vector<long>(), n.cost()));
+    }
+    auto other_nets = std::vector<long>();
+    for (const auto& [id, cost] : costs) {
+        if (net_index.count(id) == 0) {
+            other_nets.push_back(id);
+        }
+    }
+    std::sort(other_nets.begin(), other_nets.end());
+    for (auto id : other_nets) {
+        net_index[id] = (long)nets.size();
+        nets.push_back(pmondriaan::net(id, std::vector<long>(), costs[id]));
+    }
+
+    auto vertices = std::vector<pmondriaan::vertex>();
+    vertices.reserve(H.global_size());
+    size_t nr_nz = 0;
+    for (const auto& data : blocks) {
+        size_t i = 0;
+        while (i < data.size()) {
+            auto id = data[i];
+            auto weight = data[i + 1];
+            auto part = data[i + 2];
+            auto degree = data[i + 3];
+            auto first = data.begin() + i + 4;
+            vertices.push_back(
+            pmondriaan::vertex(id, std::vector<long>(first, first + degree), weight));
+            vertices.back().set_part(part);
+            for (auto n : vertices.back().nets()) {
+                nets[net_index[n]].add_vertex(id);
+            }
+            nr_nz += degree;
+            i += 4 + degree;
+        }
+    }
+    for (auto& n : nets) {
+        n.set_global_size(n.size());
+    }
+
+    return pmondriaan::hypergraph(H.global_size(), H.global_number_nets(),
+                                  std::move(vertices), std::move(nets), nr_nz);
+}
+
+#ifndef BACKEND_MPI
+/**
+ * Returns a hypergraph containing all vertices and nets of the distributed
+ * hypergraph H that is shared by all threads.
+ */
+std::shared_ptr<pmondriaan::hypergraph>
+replicate_hypergraph_shared(bulk::world& world, pmondriaan::hypergraph& H) {
+    // the threads share their address space, so the local hypergraphs are read directly
+    auto locals = bulk::gather_all(world, reinterpret_cast<std::uintptr_t>(&H));
+
+    auto H_shared = std::shared_ptr<pmondriaan::hypergraph>();
+    auto address = bulk::var<std::uintptr_t>(world);
+    if (world.rank() == 0) {
+        auto nets = std::vector<pmondriaan::net>();
+        auto net_index = std::unordered_map<long, long>();
+        auto vertices = std::vector<pmondriaan::vertex>();
+        vertices.reserve(H.global_size());
+        size_t nr_nz = 0;
+        for (auto t = 0; t < world.active_processors(); t++) {
+            auto& H_t = *reinterpret_cast<pmondriaan::hypergraph*>(locals[t]);
+            for (const auto& n : H_t.nets()) {
+                if (net_index.count(n.id()) == 0) {
+                    net_index[n.id()] = (long)nets.size();
+                    nets.push_back(pmondriaan::net(n.id(), std::vector<long>(), n.cost()));
+                }
+            }
+            for (auto& v : H_t.vertices()) {
+                vertices.push_back(pmondriaan::vertex(v.id(), v.nets(), v.weight()));
+                vertices.back().set_part(v.part());
+                for (auto n : v.nets()) {
+                    nets[net_index[n]].add_vertex(v.id());
+                }
+                nr_nz += v.degree();
+            }
+        }
+        for (auto& n : nets) {
+            n.set_global_size(n.size());
+        }
+
+        H_shared = std::make_shared<pmondriaan::hypergraph>(
+        H.global_size(), H.global_number_nets(), std::move(vertices), std::move(nets), nr_nz);
+        simplify_duplicate_nets(*H_shared);
+        address.broadcast(reinterpret_cast<std::uintptr_t>(&H_shared));
+    }
+    world.sync();
+
+    if (world.rank() != 0) {
+        H_shared = *reinterpret_cast<std::shared_ptr<pmondriaan::hypergraph>*>(address.value());
+    }
+    // the pointer of processor 0 has to stay alive until all threads have copied it
+    world.sync();
+    return H_shared;
+}
+#endif
+
+} // namespace pmondriaan
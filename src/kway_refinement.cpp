@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+#else
+#include <bulk/backends/thread/thread.hpp>
+#endif
+
+#include "hypergraph/hypergraph.hpp"
+#include "hypergraph/net_directory.hpp"
+#include "kway_refinement.hpp"
+
+namespace pmondriaan {
+
+void add_count(std::vector<std::pair<long, long>>& counts, long key, long change) {
+    auto it = std::lower_bound(counts.begin(), counts.end(), key,
+                               [](const auto& lhs, long rhs) { return lhs.first < rhs; });
+    if ((it != counts.end()) && (it->first == key)) {
+        it->second += change;
+        if (it->second == 0) {
+            counts.erase(it);
+        }
+    } else {
+        counts.insert(it, {key, change});
+    }
+}
+
+kway_counts::kway_counts(bulk::world& world,
+                         pmondriaan::hypergraph& H,
+                         pmondriaan::net_directory& directory,
+                         pmondriaan::m metric)
+: world_(world), H_(H), directory_(directory), metric_(metric), counts_(H.nets().size()),
+  owned_counts_(directory.local_count()), touched_(directory.local_count(), false),
+  changes_(world), counts_queue_(world) {
+    // every processor sends the number of pins of its nets in each part to the owners
+    for (auto i = 0u; i < H.nets().size(); i++) {
+        auto& net = H.nets()[i];
+        for (auto v : net.vertices()) {
+            add_count(counts_[i], H(H.local_id(v)).part(), 1);
+        }
+        for (const auto& [part, count] : counts_[i]) {
+            changes_(directory.owner(net.id())).send(net.id(), part, count);
+        }
+    }
+    world.sync();
+
+    for (const auto& [net, part, count] : changes_) {
+        add_count(owned_counts_[directory.local(net)], part, count);
+    }
+    auto nets = std::vector<long>(directory.local_count());
+    for (auto i = 0u; i < directory.local_count(); i++) {
+        cut_size_my_nets_ += cutsize_net(owned_counts_[i].size(), directory.cost(i), metric_);
+        nets[i] = i;
+    }
+    send_counts(nets);
+}
+
+void kway_counts::move(long i, long part) {
+    auto& v = H_(i);
+    auto from = v.part();
+    v.set_part(part);
+    for (auto n : v.nets()) {
+        auto& counts = counts_[H_.local_id_net(n)];
+        add_count(counts, from, -1);
+        add_count(counts, part, 1);
+        changes_(directory_.owner(n)).send(n, from, -1);
+        changes_(directory_.owner(n)).send(n, part, 1);
+    }
+}
+
+long kway_counts::synchronize() {
+    world_.sync();
+    auto nets = std::vector<long>();
+    for (const auto& [net, part, change] : changes_) {
+        auto i = directory_.local(net);
+        if (!touched_[i]) {
+            touched_[i] = true;
+            nets.push_back(i);
+            cut_size_my_nets_ -= cutsize_net(owned_counts_[i].size(), directory_.cost(i), metric_);
+        }
+        add_count(owned_counts_[i], part, change);
+    }
+    for (auto i : nets) {
+        touched_[i] = false;
+        cut_size_my_nets_ += cutsize_net(owned_counts_[i].size(), directory_.cost(i), metric_);
+    }
+    // the local views of all processors holding pins of a changed net are replaced
+    send_counts(nets);
+    return cut_size();
+}
+
+long kway_counts::cut_size() { return bulk::sum(world_, cut_size_my_nets_); }
+
+long kway_counts::count(const std::vector<std::pair<long, long>>& counts, long part) {
+    auto it = std::lower_bound(counts.begin(), counts.end(), part,
+                               [](const auto& lhs, long rhs) { return lhs.first < rhs; });
+    return ((it != counts.end()) && (it->first == part)) ? it->second : 0;
+}
+
+void kway_counts::send_counts(const std::vector<long>& nets) {
+    auto parts = std::vector<long>();
+    auto counts = std::vector<long>();
+    for (auto i : nets) {
+        parts.clear();
+        counts.clear();
+        for (const auto& [part, count] : owned_counts_[i]) {
+            parts.push_back(part);
+            counts.push_back(count);
+        }
+        for (auto t : directory_.procs(i)) {
+            counts_queue_(t).send(directory_.global(i), parts, counts);
+        }
+    }
+    world_.sync();
+    for (const auto& [net, parts_net, counts_net] : counts_queue_) {
+        auto& net_counts = counts_[H_.local_id_net(net)];
+        net_counts.clear();
+        for (auto j = 0u; j < parts_net.size(); j++) {
+            net_counts.emplace_back(parts_net[j], counts_net[j]);
+        }
+    }
+}
+
+namespace {
+
+/**
+ * Refines the k-way partitioning of the distributed hypergraph H, keeping the
+ * weight of every part at most max_weight, for a metric known at compile time.
+ * Returns the cutsize of the refined partitioning.
+ */
+template <pmondriaan::m metric>
+long kway_refine(bulk::world& world,
+                 pmondriaan::hypergraph& H,
+                 long k,
+                 long max_weight,
+                 pmondriaan::options& opts) {
+    auto p = world.active_processors();
+    auto directory = pmondriaan::net_directory(world, H, opts.balance_net_ownership);
+    auto counts = pmondriaan::kway_counts(world, H, directory, metric);
+    auto cut_size = counts.cut_size();
+
+    // the gain of a move of a vertex to each of the parts its nets are in
+    auto gain_part = std::vector<long>(k, 0);
+    auto candidate = std::vector<bool>(k, false);
+    auto parts = std::vector<long>();
+
+    /* Returns the part with the largest positive gain to move the vertex with
+       local id i to and the gain, or -1 if there is none. If up, only parts
+       with a higher label than the current part are considered, otherwise
+       only parts with a lower label. */
+    auto best_move = [&](long i, bool up, const std::vector<long>& budget) {
+        auto& v = H(i);
+        auto from = v.part();
+        // the part of the gain that does not depend on the part moved to
+        long gain = 0;
+        for (auto n : v.nets()) {
+            auto& net_counts = counts[H.local_id_net(n)];
+            auto cost = H.net(n).cost();
+            if constexpr (metric == pmondriaan::m::lambda_minus_one) {
+                // the net leaves the current part, and enters the new part unless it is already in it
+                if (kway_counts::count(net_counts, from) == 1) {
+                    gain += cost;
+                }
+                gain -= cost;
+                for (const auto& [part, count] : net_counts) {
+                    if (part != from) {
+                        if (!candidate[part]) {
+                            candidate[part] = true;
+                            parts.push_back(part);
+                        }
+                        gain_part[part] += cost;
+                    }
+                }
+            } else {
+                // the net gets cut if it is not yet, and is uncut if v is its only pin outside a part
+                if ((net_counts.size() == 1) && (net_counts[0].second > 1)) {
+                    gain -= cost;
+                }
+                if ((net_counts.size() == 2) && (kway_counts::count(net_counts, from) == 1)) {
+                    auto part = (net_counts[0].first == from) ? net_counts[1].first
+                                                              : net_counts[0].first;
+                    if (!candidate[part]) {
+                        candidate[part] = true;
+                        parts.push_back(part);
+                    }
+                    gain_part[part] += cost;
+                }
+            }
+        }
+
+        auto best = std::make_pair(-1l, 0l);
+        for (auto part : parts) {
+            if (((part > from) == up) && (v.weight() <= budget[part]) &&
+                (gain + gain_part[part] > best.second)) {
+                best = {part, gain + gain_part[part]};
+            }
+            candidate[part] = false;
+            gain_part[part] = 0;
+        }
+        parts.clear();
+        return best;
+    };
+
+    auto no_improvement = 0u;
+    for (auto round = 0u; (round < opts.kway_max_rounds) && (no_improvement < 2); round++) {
+        auto up = (round % 2 == 0);
+        // every processor may add an equal share of the remaining weight to a part
+        auto weights = pmondriaan::global_weight_parts(world, H, k);
+        auto budget = std::vector<long>(k);
+        for (auto part = 0; part < k; part++) {
+            budget[part] = std::max(0l, (max_weight - weights[part]) / p);
+        }
+
+        // the candidates are moved best first, with their gain recomputed
+        // because of the moves done before
+        auto candidates = std::vector<std::pair<long, long>>();
+        for (auto i = 0u; i < H.size(); i++) {
+            auto [part, gain] = best_move(i, up, budget);
+            if (part >= 0) {
+                candidates.push_back({-gain, i});
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        auto moved = std::vector<std::pair<long, long>>();
+        for (const auto& [gain, i] : candidates) {
+            auto [part, new_gain] = best_move(i, up, budget);
+            if (part >= 0) {
+                budget[part] -= H(i).weight();
+                moved.push_back({i, H(i).part()});
+                counts.move(i, part);
+            }
+        }
+
+        auto new_cut_size = counts.synchronize();
+        // moves of different processors can together increase the cutsize
+        if (new_cut_size > cut_size) {
+            for (auto it = moved.rbegin(); it != moved.rend(); it++) {
+                counts.move(it->first, it->second);
+            }
+            new_cut_size = counts.synchronize();
+        }
+        no_improvement = (new_cut_size < cut_size) ? 0 : no_improvement + 1;
+        cut_size = new_cut_size;
+    }
+    return cut_size;
+}
+
+} // namespace
+
+/**
+ * Refines the k-way partitioning of the distributed hypergraph H, keeping the
+ * weight of every part at most max_weight. Returns the cutsize of the refined
+ * partitioning.
+ */
+long kway_refine_par(bulk::world& world,
+                     pmondriaan::hypergraph& H,
+                     long k,
+                     long max_weight,
+                     pmondriaan::options& opts) {
+    if (opts.metric == pmondriaan::m::cut_net) {
+        return kway_refine<pmondriaan::m::cut_net>(world, H, k, max_weight, opts);
+    }
+    return kway_refine<pmondriaan::m::lambda_minus_one>(world, H, k, max_weight, opts);
+}
+
+} // namespace pmondriaan
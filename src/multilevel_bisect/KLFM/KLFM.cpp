@@ -12,6 +12,7 @@
 #include "hypergraph/hypergraph.hpp"
 #include "multilevel_bisect/KLFM/KLFM.hpp"
 #include "multilevel_bisect/KLFM/gain_buckets.hpp"
+#include "multilevel_bisect/KLFM/stopping_rule.hpp"
 
 namespace pmondriaan {
 
@@ -26,7 +27,8 @@ long KLFM(pmondriaan::hypergraph& H,
           long max_weight_1,
           pmondriaan::options& opts,
           std::mt19937& rng,
-          long cut_size) {
+          long cut_size,
+          pmondriaan::KLFM_statistics* stats) {
 
     size_t pass = 0;
     long prev_cut_size;
@@ -48,7 +50,7 @@ long KLFM(pmondriaan::hypergraph& H,
 
     while (pass < opts.KLFM_max_passes) {
         auto result =
-        KLFM_pass(H, C, prev_cut_size, weights, max_weight_0, max_weight_1, opts, rng);
+        KLFM_pass(H, C, prev_cut_size, weights, max_weight_0, max_weight_1, opts, rng, stats);
         if (result < prev_cut_size) {
             prev_cut_size = result;
         } else {
@@ -69,16 +71,25 @@ long KLFM_pass(pmondriaan::hypergraph& H,
                long max_weight_0,
                long max_weight_1,
                pmondriaan::options& opts,
-               std::mt19937& rng) {
+               std::mt19937& rng,
+               pmondriaan::KLFM_statistics* stats) {
 
     auto max_extra_weight = std::array<long, 2>();
     auto gain_structure = pmondriaan::gain_structure(H, C);
 
     long best_cut_size = cut_size;
     auto no_improvement_moves = std::vector<long>();
+    long moves = 0;
 
-    while (!gain_structure.done() &&
-           (no_improvement_moves.size() < opts.KLFM_max_no_gain_moves)) {
+    auto stopping = pmondriaan::stopping_rule(opts.KLFM_stopping_alpha, H.size());
+    auto stop = [&]() {
+        if (opts.KLFM_adaptive_stopping) {
+            return stopping.stop();
+        }
+        return no_improvement_moves.size() >= opts.KLFM_max_no_gain_moves;
+    };
+
+    while (!gain_structure.done() && !stop()) {
         max_extra_weight[0] = max_weight_0 - weights[0];
         max_extra_weight[1] = max_weight_1 - weights[1];
 
@@ -88,10 +99,13 @@ long KLFM_pass(pmondriaan::hypergraph& H,
 
         if (max_extra_weight[(part_to_move + 1) % 2] - H(H.local_id(v_to_move)).weight() >= 0) {
 
-            cut_size -= gain_structure.gain_next(part_to_move);
+            auto gain = gain_structure.gain_next(part_to_move);
+            cut_size -= gain;
             weights[part_to_move] -= H(H.local_id(v_to_move)).weight();
             weights[(part_to_move + 1) % 2] += H(H.local_id(v_to_move)).weight();
             gain_structure.move(v_to_move);
+            moves++;
+            stopping.add(gain, cut_size <= best_cut_size);
             if (cut_size > best_cut_size) {
                 no_improvement_moves.push_back(v_to_move);
             } else {
@@ -111,6 +125,10 @@ long KLFM_pass(pmondriaan::hypergraph& H,
         H.move(v, C);
     }
 
+    if (stats != nullptr) {
+        stats->moves += moves;
+        stats->rolled_back += no_improvement_moves.size();
+    }
     return best_cut_size;
 }
 
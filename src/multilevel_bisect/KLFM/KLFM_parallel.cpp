@@ -1,7 +1,11 @@
 #include <array>
+#include <cstdlib>
+#include <functional>
 #include <limits>
+#include <optional>
 #include <queue>
 #include <random>
+#include <unordered_map>
 
 #include <bulk/bulk.hpp>
 #ifdef BACKEND_MPI
@@ -10,9 +14,12 @@
 #include <bulk/backends/thread/thread.hpp>
 #endif
 
+#include "algorithm.hpp"
 #include "hypergraph/hypergraph.hpp"
+#include "hypergraph/net_directory.hpp"
 #include "multilevel_bisect/KLFM/KLFM_parallel.hpp"
 #include "multilevel_bisect/KLFM/gain_buckets.hpp"
+#include "multilevel_bisect/KLFM/stopping_rule.hpp"
 
 namespace pmondriaan {
 
@@ -28,7 +35,9 @@ long KLFM_par(bulk::world& world,
               long max_weight_1,
               pmondriaan::options& opts,
               std::mt19937& rng,
-              long cut_size) {
+              long cut_size,
+              pmondriaan::net_directory* directory,
+              pmondriaan::KLFM_statistics* stats) {
 
     if (((weight_0 > max_weight_0) || (weight_1 > max_weight_1)) && (world.rank() == 0)) {
         world.log("Partitioning does not adhere to balance constraint at start "
@@ -37,9 +46,16 @@ long KLFM_par(bulk::world& world,
     size_t pass = 0;
     long prev_cut_size;
 
+    // Each processor is responsible for keeping track of some nets
+    auto own_directory = std::optional<pmondriaan::net_directory>();
+    if (directory == nullptr) {
+        own_directory.emplace(world, H);
+        directory = &own_directory.value();
+    }
+
     // TODO: use C to compute cutsize without communication
     if (cut_size == std::numeric_limits<decltype(cut_size)>::max()) {
-        prev_cut_size = pmondriaan::cutsize(world, H, opts.metric);
+        prev_cut_size = pmondriaan::cutsize(world, H, opts.metric, *directory);
     } else {
         prev_cut_size = cut_size;
     }
@@ -50,20 +66,10 @@ long KLFM_par(bulk::world& world,
     auto C_loc = init_counts(H);
     H.sort_vertices_on_part(C_loc);
 
-    // Each processor is responsible for keeping track of some nets
-    auto net_partition =
-    bulk::block_partitioning<1>({H.global_number_nets()},
-                                {(size_t)world.active_processors()});
-    auto cost_my_nets =
-    bulk::coarray<long>(world, net_partition.local_count(world.rank()));
-    auto procs_my_nets =
-    std::vector<std::vector<int>>(net_partition.local_count(world.rank()));
-    init_cost_my_nets(world, H, cost_my_nets, procs_my_nets);
-
     while (pass < opts.KLFM_max_passes) {
         auto result = KLFM_pass_par(world, H, C, C_loc, prev_cut_size,
                                     total_weights, max_weight_0, max_weight_1,
-                                    cost_my_nets, procs_my_nets, opts, rng);
+                                    *directory, opts, rng, stats);
         if (result < prev_cut_size) {
             prev_cut_size = result;
         } else {
@@ -85,10 +91,10 @@ long KLFM_pass_par(bulk::world& world,
                    std::array<long, 2>& total_weights,
                    long max_weight_0,
                    long max_weight_1,
-                   bulk::coarray<long>& cost_my_nets,
-                   std::vector<std::vector<int>>& procs_my_nets,
+                   pmondriaan::net_directory& directory,
                    pmondriaan::options& opts,
-                   std::mt19937& rng) {
+                   std::mt19937& rng,
+                   pmondriaan::KLFM_statistics* stats) {
     auto s = world.rank();
     auto p = world.active_processors();
 
@@ -96,24 +102,25 @@ long KLFM_pass_par(bulk::world& world,
 
     long best_cut_size = cut_size;
     auto no_improvement_moves = std::vector<long>();
+    long moves_done = 0;
+    // every round is a step of the stopping rule, which all processors evaluate on the same cutsizes
+    auto stopping = pmondriaan::stopping_rule(opts.KLFM_stopping_alpha, H.global_size());
 
-    // Each processor is responsible for keeping track of some nets
-    auto net_partition =
-    bulk::block_partitioning<1>({H.global_number_nets()}, {(size_t)p});
     /*We keep track of the previous counts we are responsible for,
     we have the count of part 0 and the count of part 1 for each net */
-    auto previous_C = bulk::coarray<long>(world, net_partition.local_count(s) * 2);
+    auto previous_C = std::vector<long>(directory.local_count() * 2, 0);
 
-    auto cut_size_my_nets =
-    init_previous_C(world, H, C, previous_C, net_partition, cost_my_nets);
+    auto cut_size_my_nets = init_previous_C(world, H, C, previous_C, directory);
     // Store the previous counts of part 0, so we can easily check for change later
     auto prev_C_0 = std::vector<long>(H.nets().size());
     for (auto i = 0u; i < H.nets().size(); i++) {
         prev_C_0[i] = C[i][0];
     }
+    // The nets of the vertices moved since the last synchronization
+    auto changed_nets = pmondriaan::dirty_nets(H.nets().size());
 
-    // Stores the proposed moves as: gain, weight change, processor id
-    auto moves_queue = bulk::queue<long, long, int, long>(world);
+    // Stores the summaries of the proposed moves of each processor
+    auto summaries = bulk::queue<int, long[], long[]>(world);
     auto update_nets = bulk::queue<long, long>(world);
     bulk::var<long> new_weight_0(world);
     bulk::var<long> new_weight_1(world);
@@ -130,21 +137,15 @@ long KLFM_pass_par(bulk::world& world,
         std::vector<std::tuple<long, long, long>>(opts.KLFM_par_number_send_moves,
                                                   std::make_tuple(-1, 0, 0));
         find_top_moves(H, gain_structure, C_loc, moves, total_weights,
-                       max_weight_0, max_weight_1, rng);
-        // Send moves to processor 0
-        long tag = 0;
-        for (auto& move : moves) {
-            if (std::get<0>(move) == -1) {
-                break;
-            }
-            for (auto t = 0; t < p; t++) {
-                moves_queue(t).send(std::get<1>(move), std::get<2>(move), s, tag);
-            }
-            tag++;
+                       max_weight_0, max_weight_1, rng, &changed_nets);
+        // Every processor receives a summary of the moves of all processors
+        auto summary = summarize_moves(moves);
+        for (auto t = 0; t < p; t++) {
+            summaries(t).send(s, summary[0], summary[1]);
         }
         world.sync();
 
-        auto rejected = reject_unbalanced_moves(world, moves_queue, prev_total_weights,
+        auto rejected = reject_unbalanced_moves(world, summaries, prev_total_weights,
                                                 max_weight_0, max_weight_1);
         total_weights[0] = prev_total_weights[0];
         total_weights[1] = prev_total_weights[1];
@@ -155,7 +156,7 @@ long KLFM_pass_par(bulk::world& world,
             while (rejected != 0) {
                 if (std::get<2>(moves[index]) > 0) {
                     auto& vertex = H(H.local_id(std::get<0>(moves[index])));
-                    H.move(vertex.id(), C, C_loc);
+                    H.move(vertex.id(), C, C_loc, &changed_nets);
                     rejected--;
                     // We set the move to -1 so we do not add it to the no improvement moves
                     moves[index] = std::make_tuple(-1, 0, 0);
@@ -166,7 +167,7 @@ long KLFM_pass_par(bulk::world& world,
             while (rejected != 0) {
                 if (std::get<2>(moves[index]) < 0) {
                     auto& vertex = H(H.local_id(std::get<0>(moves[index])));
-                    H.move(vertex.id(), C, C_loc);
+                    H.move(vertex.id(), C, C_loc, &changed_nets);
                     rejected++;
                     // We set the move to -1 so we do not add it to the no improvement moves
                     moves[index] = std::make_tuple(-1, 0, 0);
@@ -176,21 +177,22 @@ long KLFM_pass_par(bulk::world& world,
         }
 
         // We send updates about counts in nets to responsible processors
-        for (auto i = 0u; i < H.nets().size(); i++) {
+        for (auto i : changed_nets.nets()) {
             // We only send the new count if it has been changed
             if (prev_C_0[i] != C[i][0]) {
-                update_nets(net_partition.owner(H.nets()[i].id()))
+                update_nets(directory.owner(H.nets()[i].id()))
                 .send(H.nets()[i].id(), C[i][0]);
             }
         }
         world.sync();
 
-        cut_size_my_nets = update_C(world, H, C, previous_C, prev_C_0, update_nets,
-                                    net_partition, cost_my_nets, procs_my_nets,
-                                    cut_size_my_nets, true, gain_structure);
+        cut_size_my_nets = update_C(world, H, C, previous_C, prev_C_0, update_nets, directory,
+                                    cut_size_my_nets, changed_nets, &gain_structure);
 
         // We also send all processors the total cutsize of the nets this p is responsible for
+        auto round_cut_size = cut_size;
         cut_size = bulk::sum(world, cut_size_my_nets);
+        stopping.add(round_cut_size - cut_size, cut_size <= best_cut_size);
         long moves_found = 0;
         if (cut_size > best_cut_size) {
             for (auto& move : moves) {
@@ -213,14 +215,15 @@ long KLFM_pass_par(bulk::world& world,
         if (gain_structure.done() || (moves_found == 0)) {
             done = 1;
         }
-        if (bulk::sum(done) == world.active_processors()) {
+        moves_done += moves_found;
+        if ((bulk::sum(done) == world.active_processors()) ||
+            (opts.KLFM_adaptive_stopping && stopping.stop())) {
             all_done = true;
         }
     }
 
     // Reverse moves up to best point
     long weight_change = 0;
-    auto changed_nets = std::unordered_set<long>();
     for (auto v : no_improvement_moves) {
         auto& vertex = H(H.local_id(v));
         if (vertex.part() == 0) {
@@ -228,126 +231,131 @@ long KLFM_pass_par(bulk::world& world,
         } else {
             weight_change += vertex.weight();
         }
-        for (auto n : vertex.nets()) {
-            changed_nets.insert(n);
-        }
-        H.move(v, C, C_loc);
+        H.move(v, C, C_loc, &changed_nets);
     }
 
     // We send updates about counts in nets to responsible processors
-    for (auto n : changed_nets) {
-        update_nets(net_partition.owner(n)).send(n, C[H.local_id_net(n)][0]);
+    for (auto i : changed_nets.nets()) {
+        update_nets(directory.owner(H.nets()[i].id())).send(H.nets()[i].id(), C[i][0]);
     }
     world.sync();
-    update_C(world, H, C, previous_C, prev_C_0, update_nets, net_partition,
-             cost_my_nets, procs_my_nets, cut_size_my_nets, false, gain_structure);
+    update_C(world, H, C, previous_C, prev_C_0, update_nets, directory, cut_size_my_nets,
+             changed_nets, nullptr);
 
     auto total_change = bulk::sum(world, weight_change);
     total_weights[0] += total_change;
     total_weights[1] -= total_change;
 
-    return best_cut_size;
-}
-
-void init_cost_my_nets(bulk::world& world,
-                       pmondriaan::hypergraph& H,
-                       bulk::coarray<long>& cost_my_nets,
-                       std::vector<std::vector<int>>& procs_my_nets) {
-    auto p = world.active_processors();
-    auto s = world.rank();
-    auto queue_procs = bulk::queue<long, int>(world);
-    auto net_partition =
-    bulk::block_partitioning<1>({H.global_number_nets()}, {(size_t)p});
-    for (auto i = 0u; i < net_partition.local_count(s); i++) {
-        cost_my_nets[i] = 0;
-    }
-    for (auto net : H.nets()) {
-        auto owner = net_partition.owner(net.id());
-        cost_my_nets(owner)[net_partition.local(net.id())[0]] = net.cost();
-        queue_procs(owner).send(net.id(), s);
-    }
-    world.sync();
-    for (const auto& [net_id, proc] : queue_procs) {
-        procs_my_nets[net_partition.local(net_id)[0]].push_back(proc);
+    if (stats != nullptr) {
+        stats->moves += moves_done;
+        stats->rolled_back += no_improvement_moves.size();
     }
+
+    return best_cut_size;
 }
 
 /**
- * Initializes the previous_C counts using communication and return the cutsize
- * of the nets the processor is responsible for.
+ * Initializes the previous_C counts of the nets the processor is responsible
+ * for using communication and return the cutsize of these nets.
  */
 long init_previous_C(bulk::world& world,
                      pmondriaan::hypergraph& H,
                      std::vector<std::vector<long>>& C,
-                     bulk::coarray<long>& previous_C,
-                     bulk::block_partitioning<1>& net_partition,
-                     bulk::coarray<long>& cost_my_nets) {
-    auto s = world.rank();
-    for (auto i = 0u; i < net_partition.local_count(s) * 2; i++) {
-        previous_C[i] = 0;
-    }
+                     std::vector<long>& previous_C,
+                     pmondriaan::net_directory& directory) {
+    previous_C.assign(directory.local_count() * 2, 0);
 
+    // the owner knows the global size of the net, so the count of part 0 suffices
+    auto count_queue = pmondriaan::batched_queue<long>(world);
     for (auto i = 0u; i < C.size(); i++) {
         auto net = H.global_id_net(i);
-        previous_C(net_partition.owner(net))[2 * net_partition.local(net)[0]] = C[i][0];
-        previous_C(net_partition.owner(net))[(2 * net_partition.local(net)[0]) + 1] =
-        C[i][1];
+        count_queue.send(directory.owner(net), net, C[i][0]);
+    }
+    count_queue.sync();
+    for (const auto& [net, C_0] : count_queue.received()) {
+        auto local = directory.local(net);
+        previous_C[2 * local] = C_0;
+        previous_C[(2 * local) + 1] = (long)directory.global_size(local) - C_0;
     }
-    world.sync();
 
     long cut_size_my_nets = 0;
-    for (auto i = 0u; i < net_partition.local_count(s); i++) {
+    for (auto i = 0u; i < directory.local_count(); i++) {
         if (!((previous_C[i * 2] == 0) || (previous_C[(i * 2) + 1] == 0))) {
-            cut_size_my_nets += cost_my_nets[i];
+            cut_size_my_nets += directory.cost(i);
         }
     }
     return cut_size_my_nets;
 }
 
+namespace {
+
 /**
- * Updates the gain values that were outdated.
+ * Updates the gain values that were outdated, where the cost of the net is
+ * known to be 1 if unit_cost.
  */
-void update_gains(pmondriaan::hypergraph& H,
-                  pmondriaan::net& net,
-                  std::vector<long> C_loc,
-                  std::vector<long> C_new,
-                  pmondriaan::gain_structure& gain_structure) {
+template <bool unit_cost>
+void update_gains_(pmondriaan::hypergraph& H,
+                   pmondriaan::net& net,
+                   const std::vector<long>& C_loc,
+                   const std::array<long, 2>& C_new,
+                   pmondriaan::gain_structure& gain_structure) {
+    long cost = 1;
+    if constexpr (!unit_cost) {
+        cost = net.cost();
+    }
     if (((C_new[0] == 0) && (C_loc[0] > 0)) || ((C_new[1] == 0) && (C_loc[1] > 0))) {
         for (auto v : net.vertices()) {
-            gain_structure.add_gain(v, -1 * net.cost());
+            gain_structure.add_gain(v, -1 * cost);
         }
     }
     if ((C_new[0] == 1) && (C_loc[0] > 1)) {
         auto v = net.vertices().front();
         if (H(H.local_id(v)).part() == 0) {
-            gain_structure.add_gain(v, net.cost());
+            gain_structure.add_gain(v, cost);
         }
     }
     if ((C_new[1] == 1) && (C_loc[1] > 1)) {
         auto v = net.vertices().back();
         if (H(H.local_id(v)).part() == 1) {
-            gain_structure.add_gain(v, net.cost());
+            gain_structure.add_gain(v, cost);
         }
     }
     if (((C_new[0] > 0) && (C_loc[0] == 0)) || ((C_new[1] > 0) && (C_loc[1] == 0))) {
         for (auto v : net.vertices()) {
-            gain_structure.add_gain(v, net.cost());
+            gain_structure.add_gain(v, cost);
         }
     }
     if ((C_new[0] > 1) && (C_loc[0] == 1)) {
         auto v = net.vertices().front();
         if (H(H.local_id(v)).part() == 0) {
-            gain_structure.add_gain(v, -1 * net.cost());
+            gain_structure.add_gain(v, -1 * cost);
         }
     }
     if ((C_new[1] > 1) && (C_loc[1] == 1)) {
         auto v = net.vertices().back();
         if (H(H.local_id(v)).part() == 1) {
-            gain_structure.add_gain(v, -1 * net.cost());
+            gain_structure.add_gain(v, -1 * cost);
         }
     }
 }
 
+} // namespace
+
+/**
+ * Updates the gain values that were outdated.
+ */
+void update_gains(pmondriaan::hypergraph& H,
+                  pmondriaan::net& net,
+                  const std::vector<long>& C_loc,
+                  const std::array<long, 2>& C_new,
+                  pmondriaan::gain_structure& gain_structure) {
+    if (gain_structure.unit_cost()) {
+        update_gains_<true>(H, net, C_loc, C_new, gain_structure);
+    } else {
+        update_gains_<false>(H, net, C_loc, C_new, gain_structure);
+    }
+}
+
 /**
  * Finds the best moves for a processor sequentially, by only updating local data.
  */
@@ -358,7 +366,8 @@ void find_top_moves(pmondriaan::hypergraph& H,
                     std::array<long, 2>& weights,
                     long max_weight_0,
                     long max_weight_1,
-                    std::mt19937& rng) {
+                    std::mt19937& rng,
+                    pmondriaan::dirty_nets* changed) {
     auto max_extra_weight = std::array<long, 2>();
     auto moves_found = 0u;
 
@@ -389,7 +398,7 @@ void find_top_moves(pmondriaan::hypergraph& H,
                 weights[1] -= weight_v;
                 weights[0] += weight_v;
             }
-            gain_structure.move(v_to_move, C_loc);
+            gain_structure.move(v_to_move, C_loc, changed);
             moves_found++;
         } else {
             gain_structure.remove(v_to_move);
@@ -397,73 +406,94 @@ void find_top_moves(pmondriaan::hypergraph& H,
     }
 }
 
+/**
+ * Summarizes the moves of a processor for the balance resolution.
+ */
+std::array<std::vector<long>, 2>
+summarize_moves(std::vector<std::tuple<long, long, long>>& moves) {
+    auto summary = std::array<std::vector<long>, 2>();
+    auto key = std::array<long, 2>{std::numeric_limits<long>::min(),
+                                   std::numeric_limits<long>::min()};
+    auto total = std::array<long, 2>{0, 0};
+    // the moves are undone starting from the last one
+    for (auto it = moves.rbegin(); it != moves.rend(); it++) {
+        auto [v, gain, weight_change] = *it;
+        if ((v == -1) || (weight_change == 0)) {
+            continue;
+        }
+        auto direction = (weight_change > 0) ? 0 : 1;
+        key[direction] = std::max(key[direction], gain);
+        total[direction] += std::abs(weight_change);
+        summary[direction].push_back(key[direction]);
+        summary[direction].push_back(total[direction]);
+    }
+    return summary;
+}
+
 /**
  * Determines how many moves from part 0 or 1 should be rejected on each processor.
  * Return the number of rejected moves for this processor. This is positive when
  * we have to move back vertices from part 0 to part 1 and negative otherwise.
  */
 long reject_unbalanced_moves(bulk::world& world,
-                             bulk::queue<long, long, int, long>& moves_queue,
+                             bulk::queue<int, long[], long[]>& summaries,
                              std::array<long, 2>& total_weights,
                              long max_weight_0,
                              long max_weight_1) {
     auto p = world.active_processors();
-    // The number of moves to be rejected for each processor
-    auto rejected = std::vector<long>(p, 0);
-    auto done = std::vector<bool>(p, false);
-
-    // Sort queue on gain
-    std::sort(moves_queue.begin(), moves_queue.end(), [](auto lhs, auto rhs) {
-        if (std::get<0>(lhs) == std::get<0>(rhs)) {
-            return std::get<3>(lhs) > std::get<3>(rhs);
-        } else {
-            return std::get<0>(lhs) < std::get<0>(rhs);
-        }
-    });
-    std::queue<std::pair<long, long>> received_moves;
+    auto summary = std::vector<std::array<std::vector<long>, 2>>(p);
     long total_balance = 0;
-    for (const auto& [gain, weight_change, t, tag] : moves_queue) {
-        total_balance += weight_change;
-        received_moves.push(std::make_pair(weight_change, t));
-        (void)gain;
-        (void)tag;
+    for (const auto& [t, summary_0, summary_1] : summaries) {
+        summary[t][0] = summary_0;
+        summary[t][1] = summary_1;
+        if (!summary_0.empty()) {
+            total_balance += summary_0.back();
+        }
+        if (!summary_1.empty()) {
+            total_balance -= summary_1.back();
+        }
     }
     total_weights[0] += total_balance;
     total_weights[1] -= total_balance;
-    while (total_weights[0] > max_weight_0) {
-        if (received_moves.empty()) {
-            break;
-        }
-        auto weight_change = received_moves.front().first;
-        auto t = received_moves.front().second;
-        if ((weight_change > 0) && (!done[t])) {
-            if (total_weights[1] + weight_change <= max_weight_1) {
-                rejected[t]++;
-                total_weights[0] -= weight_change;
-                total_weights[1] += weight_change;
-            } else {
-                done[t] = true;
-            }
-        }
-        received_moves.pop();
+
+    auto max_weights = std::array<long, 2>{max_weight_0, max_weight_1};
+    auto heavy = -1;
+    if (total_weights[0] > max_weight_0) {
+        heavy = 0;
+    } else if (total_weights[1] > max_weight_1) {
+        heavy = 1;
+    }
+    if (heavy == -1) {
+        return 0;
     }
+    auto light = (heavy + 1) % 2;
 
-    while (total_weights[1] > max_weight_1) {
-        if (received_moves.empty()) {
-            break;
+    // The moves into the heavy part are rejected in order of their key, every
+    // processor undoing its moves from the last one. All processors merge the
+    // same summaries, so they reach the same decision.
+    auto rejected = std::vector<long>(p, 0);
+    auto next = std::priority_queue<std::pair<long, int>, std::vector<std::pair<long, int>>,
+                                    std::greater<std::pair<long, int>>>();
+    for (auto t = 0; t < p; t++) {
+        if (!summary[t][heavy].empty()) {
+            next.push({summary[t][heavy][0], t});
         }
-        auto weight_change = received_moves.front().first;
-        auto t = received_moves.front().second;
-        if ((weight_change < 0) && (!done[t])) {
-            if (total_weights[0] - weight_change <= max_weight_0) {
-                rejected[t]--;
-                total_weights[0] -= weight_change;
-                total_weights[1] += weight_change;
-            } else {
-                done[t] = true;
-            }
+    }
+    while ((total_weights[heavy] > max_weights[heavy]) && !next.empty()) {
+        auto t = next.top().second;
+        next.pop();
+        auto index = 2 * std::abs(rejected[t]);
+        auto weight = summary[t][heavy][index + 1] - ((index == 0) ? 0 : summary[t][heavy][index - 1]);
+        if (total_weights[light] + weight > max_weights[light]) {
+            // this processor cannot undo any further moves
+            continue;
+        }
+        rejected[t] += (heavy == 0) ? 1 : -1;
+        total_weights[heavy] -= weight;
+        total_weights[light] += weight;
+        if (index + 2 < (long)summary[t][heavy].size()) {
+            next.push({summary[t][heavy][index + 2], t});
         }
-        received_moves.pop();
     }
     return rejected[world.rank()];
 }
@@ -474,68 +504,61 @@ long reject_unbalanced_moves(bulk::world& world,
 long update_C(bulk::world& world,
               pmondriaan::hypergraph& H,
               std::vector<std::vector<long>>& C,
-              bulk::coarray<long>& previous_C,
+              std::vector<long>& previous_C,
               std::vector<long>& prev_C_0,
               bulk::queue<long, long>& update_nets,
-              bulk::partitioning<1>& net_partition,
-              bulk::coarray<long>& cost_my_nets,
-              std::vector<std::vector<int>>& procs_my_nets,
+              pmondriaan::net_directory& directory,
               long cut_size_my_nets,
-              bool update_g,
-              pmondriaan::gain_structure& gain_structure) {
-    auto s = world.rank();
-    auto C_new = std::vector<std::vector<long>>(net_partition.local_count(s),
-                                                std::vector<long>(2, 0));
-    for (auto i = 0u; i < net_partition.local_count(s); i++) {
-        C_new[i][0] = previous_C[2 * i];
-        C_new[i][1] = previous_C[(2 * i) + 1];
-    }
-    // Update the counts of my nets
+              pmondriaan::dirty_nets& changed_nets,
+              pmondriaan::gain_structure* gain_structure) {
+    // Update the counts of my nets, only the nets we received updates for can change
+    auto C_new = std::unordered_map<long, std::array<long, 2>>();
     for (const auto& [net, C_0] : update_nets) {
-        auto local = net_partition.local(net)[0];
+        auto local = directory.local(net);
+        auto& counts =
+        C_new.try_emplace(local, std::array<long, 2>{previous_C[2 * local], previous_C[(2 * local) + 1]})
+        .first->second;
         auto change = C_0 - previous_C[2 * local];
         if (change != 0) {
-            if ((C_new[local][0] == 0) || (C_new[local][1] == 0)) {
-                cut_size_my_nets += cost_my_nets[net_partition.local(net)[0]];
+            if ((counts[0] == 0) || (counts[1] == 0)) {
+                cut_size_my_nets += directory.cost(local);
             }
-            C_new[local][0] += change;
-            C_new[local][1] -= change;
-            if ((C_new[local][0] == 0) || (C_new[local][1] == 0)) {
-                cut_size_my_nets -= cost_my_nets[net_partition.local(net)[0]];
+            counts[0] += change;
+            counts[1] -= change;
+            if ((counts[0] == 0) || (counts[1] == 0)) {
+                cut_size_my_nets -= directory.cost(local);
             }
         }
     }
     // We send changed counts to all processors
-    for (auto i = 0u; i < net_partition.local_count(s); i++) {
-        if (previous_C[2 * i] != C_new[i][0]) {
-            for (auto t : procs_my_nets[i]) {
-                update_nets(t).send(net_partition.global(i, s)[0], C_new[i][0]);
+    for (const auto& [local, counts] : C_new) {
+        if (previous_C[2 * local] != counts[0]) {
+            for (auto t : directory.procs(local)) {
+                update_nets(t).send(directory.global(local), counts[0]);
             }
-            previous_C[2 * i] = C_new[i][0];
-            previous_C[(2 * i) + 1] = C_new[i][1];
+            previous_C[2 * local] = counts[0];
+            previous_C[(2 * local) + 1] = counts[1];
         }
     }
     world.sync();
 
-    // We make prev_C_0 up-to-date with the new info
+    // We make prev_C_0 up-to-date with the new info, the counts can only differ
+    // from it for these nets and for the nets we changed ourselves
     for (const auto& [net, new_C_0] : update_nets) {
         prev_C_0[H.local_id_net(net)] = new_C_0;
+        changed_nets.insert(H.local_id_net(net));
     }
 
-    if (update_g) {
-        for (auto i = 0u; i < H.nets().size(); i++) {
-            if (prev_C_0[i] != C[i][0]) {
-                update_gains(H, H.nets()[i], C[i],
-                             std::vector<long>(
-                             {prev_C_0[i], (long)H.nets()[i].global_size() - prev_C_0[i]}),
-                             gain_structure);
-            }
+    for (auto i : changed_nets.nets()) {
+        if ((gain_structure != nullptr) && (prev_C_0[i] != C[i][0])) {
+            update_gains(H, H.nets()[i], C[i],
+                         {prev_C_0[i], (long)H.nets()[i].global_size() - prev_C_0[i]},
+                         *gain_structure);
         }
-    }
-    for (auto i = 0u; i < H.nets().size(); i++) {
         C[i][0] = prev_C_0[i];
         C[i][1] = H.nets()[i].global_size() - prev_C_0[i];
     }
+    changed_nets.clear();
     return cut_size_my_nets;
 }
 
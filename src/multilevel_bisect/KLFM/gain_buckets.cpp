@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <limits>
 #include <random>
@@ -10,6 +11,22 @@
 
 namespace pmondriaan {
 
+namespace {
+
+/**
+ * The cost of a net, which is not loaded if all nets have unit cost.
+ */
+template <bool unit_cost>
+long cost(const pmondriaan::net& net) {
+    if constexpr (unit_cost) {
+        return 1;
+    } else {
+        return net.cost();
+    }
+}
+
+} // namespace
+
 void gain_buckets::insert(long id, long gain) {
     auto index = gain_to_index(gain);
     if (buckets[index].empty()) {
@@ -78,6 +95,24 @@ long gain_buckets::find_next_index() {
     }
 }
 
+gain_structure::gain_structure(pmondriaan::hypergraph& H, std::vector<std::vector<long>>& C)
+: H_(H), C_(C) {
+    unit_cost_ = compute_unit_cost();
+    buckets = std::vector<pmondriaan::gain_buckets>(2, gain_buckets(compute_size_buckets()));
+    gains = std::vector<long>(H.size());
+    if (unit_cost_) {
+        init_<true>();
+    } else {
+        init_<false>();
+    }
+}
+
+bool gain_structure::compute_unit_cost() {
+    return std::all_of(H_.nets().begin(), H_.nets().end(),
+                       [](const auto& net) { return net.cost() == 1; });
+}
+
+template <bool unit_cost>
 void gain_structure::init_() {
     auto max_gain = std::vector<long>(2, buckets[0].index_to_gain(0));
     for (auto i = 0u; i < H_.size(); i++) {
@@ -86,11 +121,13 @@ void gain_structure::init_() {
         long from = v.part();
         long to = (v.part() + 1) % 2;
         for (auto n : v.nets()) {
-            if (C_[H_.local_id_net(n)][from] == 1) {
-                gain += H_.net(n).cost();
+            auto index = H_.local_id_net(n);
+            auto& counts = C_[index];
+            if (counts[from] == 1) {
+                gain += cost<unit_cost>(H_.nets()[index]);
             }
-            if (C_[H_.local_id_net(n)][to] == 0) {
-                gain -= H_.net(n).cost();
+            if (counts[to] == 0) {
+                gain -= cost<unit_cost>(H_.nets()[index]);
             }
         }
         buckets[from].insert(v.id(), gain);
@@ -131,6 +168,25 @@ long gain_structure::part_next(long max_extra_weight_0, long max_extra_weight_1,
 }
 
 void gain_structure::move(long v) {
+    if (unit_cost_) {
+        move_<true>(v);
+    } else {
+        move_<false>(v);
+    }
+}
+
+void gain_structure::move(long v,
+                          std::vector<std::vector<long>>& C_loc,
+                          pmondriaan::dirty_nets* changed) {
+    if (unit_cost_) {
+        move_<true>(v, C_loc, changed);
+    } else {
+        move_<false>(v, C_loc, changed);
+    }
+}
+
+template <bool unit_cost>
+void gain_structure::move_(long v) {
     auto& vertex = H_(H_.local_id(v));
     long from = vertex.part();
     long to = (vertex.part() + 1) % 2;
@@ -141,58 +197,63 @@ void gain_structure::move(long v) {
     gains[H_.local_id(v)] = std::numeric_limits<long>::min();
 
     for (auto n : vertex.nets()) {
-        if (C_[H_.local_id_net(n)][to] == 0) {
-            for (auto u : H_.net(n).vertices()) {
-                add_gain(u, H_.net(n).cost());
+        auto index = H_.local_id_net(n);
+        auto& net = H_.nets()[index];
+        auto& counts = C_[index];
+        if (counts[to] == 0) {
+            for (auto u : net.vertices()) {
+                add_gain(u, cost<unit_cost>(net));
             }
         }
-        if (C_[H_.local_id_net(n)][to] == 1) {
+        if (counts[to] == 1) {
             long u = -1;
             if (to == 1) {
-                u = H_.net(n).vertices()[H_.net(n).size() - 1];
+                u = net.vertices()[net.size() - 1];
             } else {
-                u = H_.net(n).vertices()[0];
+                u = net.vertices()[0];
             }
 
             if (H_(H_.local_id(u)).part() != to || u == v) {
                 std::cout << "Adding gain to wrong vertex!!\n";
-                for (auto t : H_.net(n).vertices()) {
+                for (auto t : net.vertices()) {
                     std::cout << H_(H_.local_id(t)).part() << " ";
                 }
             }
-            add_gain(u, -1 * H_.net(n).cost());
+            add_gain(u, -1 * cost<unit_cost>(net));
         }
 
-        C_[H_.local_id_net(n)][to]++;
-        C_[H_.local_id_net(n)][from]--;
+        counts[to]++;
+        counts[from]--;
 
-        if (C_[H_.local_id_net(n)][from] == 0) {
-            for (auto u : H_.net(n).vertices()) {
-                add_gain(u, -1 * H_.net(n).cost());
+        if (counts[from] == 0) {
+            for (auto u : net.vertices()) {
+                add_gain(u, -1 * cost<unit_cost>(net));
             }
         }
-        if (C_[H_.local_id_net(n)][from] == 1) {
+        if (counts[from] == 1) {
             long u = -1;
             if (from == 1) {
-                u = H_.net(n).vertices()[H_.net(n).size() - 1];
+                u = net.vertices()[net.size() - 1];
             } else {
-                u = H_.net(n).vertices()[0];
+                u = net.vertices()[0];
             }
 
             if (H_(H_.local_id(u)).part() != from || u == v) {
                 std::cout << "Adding gain to wrong vertex from " << from
-                          << "C: " << C_[H_.local_id_net(n)][0] << " "
-                          << C_[H_.local_id_net(n)][1] << "!!\n";
-                for (auto t : H_.net(n).vertices()) {
+                          << "C: " << counts[0] << " " << counts[1] << "!!\n";
+                for (auto t : net.vertices()) {
                     std::cout << t << " " << H_(H_.local_id(t)).part() << " ";
                 }
             }
-            add_gain(u, H_.net(n).cost());
+            add_gain(u, cost<unit_cost>(net));
         }
     }
 }
 
-void gain_structure::move(long v, std::vector<std::vector<long>>& C_loc) {
+template <bool unit_cost>
+void gain_structure::move_(long v,
+                           std::vector<std::vector<long>>& C_loc,
+                           pmondriaan::dirty_nets* changed) {
     auto& vertex = H_(H_.local_id(v));
     long from = vertex.part();
     long to = (vertex.part() + 1) % 2;
@@ -203,47 +264,54 @@ void gain_structure::move(long v, std::vector<std::vector<long>>& C_loc) {
     gains[H_.local_id(v)] = std::numeric_limits<long>::min();
 
     for (auto n : vertex.nets()) {
-        if (C_[H_.local_id_net(n)][to] == 0) {
-            for (auto u : H_.net(n).vertices()) {
-                add_gain(u, H_.net(n).cost());
+        auto index = H_.local_id_net(n);
+        auto& net = H_.nets()[index];
+        auto& counts = C_[index];
+        auto& counts_loc = C_loc[index];
+        if (counts[to] == 0) {
+            for (auto u : net.vertices()) {
+                add_gain(u, cost<unit_cost>(net));
             }
         }
-        if ((C_[H_.local_id_net(n)][to] == 1) && (C_loc[H_.local_id_net(n)][to] == 1)) {
+        if ((counts[to] == 1) && (counts_loc[to] == 1)) {
             long u = -1;
             if (to == 1) {
-                u = H_.net(n).vertices()[H_.net(n).size() - 1];
+                u = net.vertices()[net.size() - 1];
             } else {
-                u = H_.net(n).vertices()[0];
+                u = net.vertices()[0];
             }
 
             if (H_(H_.local_id(u)).part() != to || u == v) {
                 std::cout << "Adding gain to wrong vertex!!";
             }
-            add_gain(u, -1 * H_.net(n).cost());
+            add_gain(u, -1 * cost<unit_cost>(net));
         }
 
-        C_[H_.local_id_net(n)][to]++;
-        C_[H_.local_id_net(n)][from]--;
-        C_loc[H_.local_id_net(n)][to]++;
-        C_loc[H_.local_id_net(n)][from]--;
+        counts[to]++;
+        counts[from]--;
+        counts_loc[to]++;
+        counts_loc[from]--;
+        if (changed != nullptr) {
+            changed->insert(index);
+        }
 
-        if (C_[H_.local_id_net(n)][from] == 0) {
-            for (auto u : H_.net(n).vertices()) {
-                add_gain(u, -1 * H_.net(n).cost());
+        if (counts[from] == 0) {
+            for (auto u : net.vertices()) {
+                add_gain(u, -1 * cost<unit_cost>(net));
             }
         }
-        if ((C_[H_.local_id_net(n)][from] == 1) && (C_loc[H_.local_id_net(n)][from] == 1)) {
+        if ((counts[from] == 1) && (counts_loc[from] == 1)) {
             long u = -1;
             if (from == 1) {
-                u = H_.net(n).vertices()[H_.net(n).size() - 1];
+                u = net.vertices()[net.size() - 1];
             } else {
-                u = H_.net(n).vertices()[0];
+                u = net.vertices()[0];
             }
 
             if (H_(H_.local_id(u)).part() != from || u == v) {
                 std::cout << "Adding gain to wrong vertex!!";
             }
-            add_gain(u, H_.net(n).cost());
+            add_gain(u, cost<unit_cost>(net));
         }
     }
 }
@@ -269,6 +337,11 @@ bool gain_structure::done() {
 long gain_structure::compute_size_buckets() {
     long max_value = 0;
     for (auto& v : H_.vertices()) {
+        // with unit costs, the largest gain is the degree of a vertex
+        if (unit_cost_) {
+            max_value = std::max(max_value, (long)v.degree());
+            continue;
+        }
         long sum = 0;
         for (auto n : v.nets()) {
             sum += H_.net(n).cost();
@@ -0,0 +1,34 @@
+#include <algorithm>
+#include <cmath>
+
+#include "multilevel_bisect/KLFM/stopping_rule.hpp"
+
+namespace pmondriaan {
+
+stopping_rule::stopping_rule(double alpha, long size)
+: alpha_(alpha), beta_(std::log(std::max(size, 2l))) {}
+
+void stopping_rule::add(long gain, bool improved) {
+    if (improved) {
+        steps_ = 0;
+        mean_ = 0.0;
+        squares_ = 0.0;
+        return;
+    }
+    // the mean and variance are updated incrementally
+    steps_++;
+    auto delta = gain - mean_;
+    mean_ += delta / steps_;
+    squares_ += delta * (gain - mean_);
+}
+
+bool stopping_rule::stop() const {
+    // the first steps do not say enough about the gains
+    if ((steps_ <= beta_) || (mean_ >= 0.0)) {
+        return false;
+    }
+    auto variance = squares_ / steps_;
+    return steps_ * mean_ * mean_ > alpha_ * variance + beta_;
+}
+
+} // namespace pmondriaan
@@ -11,6 +11,7 @@
 #include <bulk/backends/thread/thread.hpp>
 #endif
 
+#include "algorithm.hpp"
 #include "bisect.hpp"
 #include "hypergraph/contraction.hpp"
 #include "hypergraph/hypergraph.hpp"
@@ -20,13 +21,15 @@
 namespace pmondriaan {
 
 /**
- * Coarsens the hypergraph H and returns a new hypergraph HC.
+ * Coarsens the hypergraph H and returns a new hypergraph HC. If same_part,
+ * only vertices in the same part are contracted.
  */
 pmondriaan::hypergraph coarsen_hypergraph_par(bulk::world& world,
                                               pmondriaan::hypergraph& H,
                                               pmondriaan::contraction& C,
                                               pmondriaan::options& opts,
-                                              std::mt19937& rng) {
+                                              std::mt19937& rng,
+                                              bool same_part) {
     auto s = world.rank();
     auto p = world.active_processors();
 
@@ -38,11 +41,12 @@ pmondriaan::hypergraph coarsen_hypergraph_par(bulk::world& world,
         indices_samples = sample_lp(H, opts, rng);
     }
 
-    // we now send the samples and the processor id to all processors
-    auto sample_queue = bulk::queue<long, long, long[]>(world);
+    // we now send the samples, their part and the processor id to all processors
+    auto sample_queue = bulk::queue<long, long, long, long[]>(world);
     for (auto i = 0u; i < indices_samples.size(); i++) {
         for (long t = 0; t < p; t++) {
-            sample_queue(t).send(s, (long)i, H(indices_samples[i]).nets());
+            sample_queue(t).send(s, (long)i, H(indices_samples[i]).part(),
+                                 H(indices_samples[i]).nets());
         }
     }
 
@@ -52,7 +56,7 @@ pmondriaan::hypergraph coarsen_hypergraph_par(bulk::world& world,
     auto accepted_matches = bulk::queue<long, long>(world);
     // after his funtion, accepted matches contains the matches that have been accepted
 
-    request_matches(H, C, sample_queue, accepted_matches, indices_samples, opts);
+    request_matches(H, C, sample_queue, accepted_matches, indices_samples, opts, same_part);
 
     // queue to send the information about the accepted samples
     auto info_queue = bulk::queue<long, long, long[], long[]>(world);
@@ -70,14 +74,16 @@ pmondriaan::hypergraph coarsen_hypergraph_par(bulk::world& world,
 
 /**
  * Sends match request to the owners of the best matches found using the
- * improduct computation. Returns the local matches.
+ * improduct computation. Returns the local matches. If same_part, vertices
+ * only request samples in their own part.
  */
 void request_matches(pmondriaan::hypergraph& H,
                      pmondriaan::contraction& C,
-                     bulk::queue<long, long, long[]>& sample_queue,
+                     bulk::queue<long, long, long, long[]>& sample_queue,
                      bulk::queue<long, long>& accepted_matches,
                      const std::vector<long>& indices_samples,
-                     pmondriaan::options opts) {
+                     pmondriaan::options opts,
+                     bool same_part) {
 
     auto& world = sample_queue.world();
     auto s = world.rank();
@@ -92,11 +98,14 @@ void request_matches(pmondriaan::hypergraph& H,
     auto current_ip = std::vector<double>(H.size(), 0.0);
     std::unordered_set<long> changed_indices;
 
-    for (const auto& [t, number_sample, sample_nets] : sample_queue) {
+    for (const auto& [t, number_sample, part, sample_nets] : sample_queue) {
         for (auto n_id : sample_nets) {
             if (H.is_local_net(n_id)) {
                 double scaled_cost = H.net(n_id).scaled_cost();
                 for (auto u_id : H.net(n_id).vertices()) {
+                    if (same_part && (H(H.local_id(u_id)).part() != part)) {
+                        continue;
+                    }
                     current_ip[H.local_id(u_id)] += scaled_cost;
                     changed_indices.insert(H.local_id(u_id));
                 }
@@ -255,6 +264,7 @@ pmondriaan::hypergraph contract_hypergraph(bulk::world& world,
             auto new_v_nets = std::vector<long>();
             new_v_nets.insert(new_v_nets.begin(), v.nets().begin(), v.nets().end());
             auto new_v = pmondriaan::vertex(v.id(), new_v_nets, v.weight());
+            new_v.set_part(v.part());
             new_vertices.push_back(new_v);
 
             for (auto n : new_v.nets()) {
@@ -314,15 +324,123 @@ pmondriaan::hypergraph contract_hypergraph(bulk::world& world,
     return HC;
 }
 
+/**
+ * Contracts all vertices of a distributed hypergraph H that are contained in
+ * exactly the same nets and returns the contracted hypergraph HC.
+ */
+pmondriaan::hypergraph contract_identical_vertices(bulk::world& world,
+                                                   pmondriaan::hypergraph& H,
+                                                   pmondriaan::contraction& C,
+                                                   pmondriaan::options& opts) {
+    auto s = world.rank();
+    auto net_partition =
+    bulk::block_partitioning<1>({H.global_number_nets()},
+                                {(size_t)world.active_processors()});
+
+    // identical vertices share their smallest net, so they meet at the owner of that net
+    auto fingerprint_queue = bulk::queue<long, size_t, size_t, long, long, long, int>(world);
+    for (auto& v : H.vertices()) {
+        if (v.degree() == 0) {
+            continue;
+        }
+        size_t fingerprint = 0;
+        size_t fingerprint_2 = 0;
+        for (auto n : v.nets()) {
+            fingerprint += hash_id(n);
+            fingerprint_2 += hash_id_2(n);
+        }
+        auto min_net = *std::min_element(v.nets().begin(), v.nets().end());
+        fingerprint_queue(net_partition.owner(min_net))
+        .send(min_net, fingerprint, fingerprint_2, (long)v.degree(), v.id(), v.weight(), s);
+    }
+    world.sync();
+
+    std::sort(fingerprint_queue.begin(), fingerprint_queue.end());
+
+    // vertices are only identical if both fingerprints and the degree match, each group
+    // is split into clusters of at most the maximum cluster size
+    auto merged_queue = bulk::queue<long>(world);
+    auto identical_queue = bulk::queue<long, long, long, int>(world);
+    auto first = fingerprint_queue.begin();
+    size_t cluster_size = 0;
+    for (auto it = fingerprint_queue.begin(); it != fingerprint_queue.end(); it++) {
+        if ((it == first) || (std::get<0>(*it) != std::get<0>(*first)) ||
+            (std::get<1>(*it) != std::get<1>(*first)) ||
+            (std::get<2>(*it) != std::get<2>(*first)) ||
+            (std::get<3>(*it) != std::get<3>(*first)) ||
+            (cluster_size >= opts.coarsening_max_clustersize)) {
+            first = it;
+            cluster_size = 1;
+            continue;
+        }
+        const auto& [min_net, fingerprint, fingerprint_2, degree, id, weight, t] = *it;
+        (void)min_net;
+        (void)fingerprint;
+        (void)fingerprint_2;
+        (void)degree;
+        merged_queue(t).send(id);
+        identical_queue(std::get<6>(*first)).send(std::get<4>(*first), id, weight, t);
+        cluster_size++;
+    }
+    world.sync();
+
+    auto matched = std::vector<bool>(H.size(), false);
+    for (const auto& id : merged_queue) {
+        matched[H.local_id(id)] = true;
+    }
+
+    auto extra_weight = std::vector<long>(H.size(), 0);
+    std::unordered_map<long, long> sample_index;
+    for (const auto& [sample, id, weight, t] : identical_queue) {
+        auto insert_result = sample_index.insert({sample, (long)C.size()});
+        if (insert_result.second) {
+            C.add_sample(sample);
+        }
+        C.add_match(insert_result.first->second, id, t);
+        extra_weight[H.local_id(sample)] += weight;
+    }
+    C.set_identical(true);
+
+    auto new_nets = std::vector<pmondriaan::net>();
+    std::unordered_map<long, long> net_global_to_local;
+    auto new_vertices = std::vector<pmondriaan::vertex>();
+    for (auto index = 0u; index < H.size(); index++) {
+        if (!matched[index]) {
+            auto& v = H(index);
+            new_vertices.push_back(
+            pmondriaan::vertex(v.id(), v.nets(), v.weight() + extra_weight[index]));
+            for (auto n : v.nets()) {
+                auto insert_result = net_global_to_local.insert({n, new_nets.size()});
+                if (insert_result.second) {
+                    new_nets.push_back(
+                    pmondriaan::net(n, std::vector<long>(), H.net(n).cost()));
+                }
+                new_nets[insert_result.first->second].add_vertex(v.id());
+            }
+        }
+    }
+
+    auto new_size = new_vertices.size();
+    auto new_global_size = bulk::sum(world, new_size);
+    auto HC = pmondriaan::hypergraph(new_global_size, H.global_number_nets(),
+                                     new_vertices, new_nets);
+
+    remove_free_nets(world, HC, 1);
+    C.merge_free_vertices(world, HC);
+
+    return HC;
+}
 
 /**
- * Coarsens the hypergraph H and returns a hypergraph HC sequentially.
+ * Coarsens the hypergraph H and returns a hypergraph HC sequentially. If
+ * same_part, only vertices in the same part are contracted.
  */
 pmondriaan::hypergraph coarsen_hypergraph_seq(bulk::world& world,
                                               pmondriaan::hypergraph& H,
                                               pmondriaan::contraction& C,
                                               pmondriaan::options& opts,
-                                              std::mt19937& rng) {
+                                              std::mt19937& rng,
+                                              bool same_part) {
     auto matches = std::vector<std::vector<long>>(H.size(), std::vector<long>());
     auto matched = std::vector<bool>(H.size(), false);
     // contains the vertices of the contracted hypergraph
@@ -342,7 +460,8 @@ pmondriaan::hypergraph coarsen_hypergraph_seq(bulk::world& world,
                 double scaled_cost = H.net(n_id).scaled_cost();
                 for (auto u_id : H.net(n_id).vertices()) {
                     auto u_local = H.local_id(u_id);
-                    if ((!matched[u_local]) && (u_local != i)) {
+                    if ((!matched[u_local]) && (u_local != i) &&
+                        (!same_part || (H(u_local).part() == v.part()))) {
                         if (ip[u_local] == 0.0) {
                             visited.push_back(u_local);
                         }
@@ -378,10 +497,38 @@ pmondriaan::hypergraph coarsen_hypergraph_seq(bulk::world& world,
     return result;
 }
 
+/**
+ * Coarsens the hypergraph H sequentially by contracting all vertices that were
+ * in the same cluster at the given level of the hierarchy of a parent hypergraph.
+ */
+pmondriaan::hypergraph coarsen_hypergraph_projected(bulk::world& world,
+                                                    pmondriaan::hypergraph& H,
+                                                    pmondriaan::contraction& C,
+                                                    pmondriaan::hierarchy& parent,
+                                                    size_t level) {
+    auto matches = std::vector<std::vector<long>>(H.size(), std::vector<long>());
+    auto new_v = std::vector<pmondriaan::vertex>();
+
+    // the first vertex of each cluster in H represents the cluster
+    std::unordered_map<long, long> cluster_to_local;
+    for (auto i = 0u; i < H.size(); i++) {
+        auto& v = H(i);
+        auto cluster = parent.representative(v.id(), level);
+        auto insert_result = cluster_to_local.insert({cluster, i});
+        if (insert_result.second) {
+            add_v_to_list(new_v, v);
+        } else {
+            matches[insert_result.first->second].push_back(v.id());
+        }
+    }
+    return pmondriaan::contract_hypergraph(world, H, C, matches, new_v);
+}
+
 void add_v_to_list(std::vector<pmondriaan::vertex>& v_list, pmondriaan::vertex& v) {
     auto new_v_nets = std::vector<long>();
     new_v_nets.insert(new_v_nets.begin(), v.nets().begin(), v.nets().end());
     v_list.push_back(pmondriaan::vertex(v.id(), new_v_nets, v.weight()));
+    v_list.back().set_part(v.part());
 }
 
 pmondriaan::hypergraph contract_hypergraph(bulk::world& world,
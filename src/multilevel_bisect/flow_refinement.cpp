@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <queue>
+#include <vector>
+
+#include "hypergraph/hypergraph.hpp"
+#include "multilevel_bisect/flow_refinement.hpp"
+#include "util/max_flow.hpp"
+
+namespace pmondriaan {
+
+namespace {
+
+/**
+ * Grows the region of part around the cut by breadth-first search from the
+ * vertices in cut nets, adding only vertices that keep the weight of the
+ * region at most max_weight. The local ids of the vertices are added to region.
+ */
+void grow_region(pmondriaan::hypergraph& H,
+                 std::vector<std::vector<long>>& C,
+                 long part,
+                 long max_weight,
+                 std::vector<bool>& in_region,
+                 std::vector<long>& region) {
+    auto seen = std::vector<bool>(H.size(), false);
+    auto queue = std::queue<long>();
+    for (auto i = 0u; i < H.nets().size(); i++) {
+        if ((C[i][0] > 0) && (C[i][1] > 0)) {
+            for (auto v : H.nets()[i].vertices()) {
+                auto local = H.local_id(v);
+                if ((H(local).part() == part) && !seen[local]) {
+                    seen[local] = true;
+                    queue.push(local);
+                }
+            }
+        }
+    }
+
+    long weight = 0;
+    while (!queue.empty() && (weight < max_weight)) {
+        auto local = queue.front();
+        queue.pop();
+        if (weight + H(local).weight() > max_weight) {
+            continue;
+        }
+        weight += H(local).weight();
+        in_region[local] = true;
+        region.push_back(local);
+        for (auto n : H(local).nets()) {
+            for (auto u : H.net(n).vertices()) {
+                auto local_u = H.local_id(u);
+                if ((H(local_u).part() == part) && !seen[local_u]) {
+                    seen[local_u] = true;
+                    queue.push(local_u);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+long flow_refine(pmondriaan::hypergraph& H,
+                 std::vector<std::vector<long>>& C,
+                 std::vector<long>& weights,
+                 long max_weight_0,
+                 long max_weight_1,
+                 pmondriaan::options& opts,
+                 long cut_size) {
+    auto max_weights = std::array<long, 2>{max_weight_0, max_weight_1};
+    auto alpha = opts.flow_region_factor;
+    auto in_region = std::vector<bool>(H.size(), false);
+    auto node = std::vector<long>(H.size(), -1);
+    auto net_node = std::vector<long>(H.nets().size(), -1);
+
+    while (alpha >= 1.0) {
+        /* The region in part 0 may hold the weight part 1 can take on top of its
+           weight in a perfectly balanced bisection, times alpha, plus what part 1
+           needs to reach that weight, and the other way around. With alpha 1
+           every cut of the network is balanced. */
+        auto total_weight = weights[0] + weights[1];
+        auto region = std::vector<long>();
+        auto region_weight = std::array<long, 2>{0, 0};
+        for (auto part = 0; part < 2; part++) {
+            auto other = (part + 1) % 2;
+            auto target = (double)total_weight * (double)max_weights[other] /
+                          (double)(max_weight_0 + max_weight_1);
+            auto bound =
+            (long)(target + alpha * ((double)max_weights[other] - target)) - weights[other];
+            auto start = region.size();
+            grow_region(H, C, part, bound, in_region, region);
+            for (auto i = start; i < region.size(); i++) {
+                region_weight[part] += H(region[i]).weight();
+            }
+        }
+        if (region.empty()) {
+            break;
+        }
+
+        // the source is node 0, the sink node 1, then the vertices of the region
+        // and an incoming and an outgoing node for every net with a pin in the region
+        long nodes = 2;
+        for (auto local : region) {
+            node[local] = nodes++;
+        }
+        auto nets = std::vector<long>();
+        for (auto local : region) {
+            for (auto n : H(local).nets()) {
+                auto i = H.local_id_net(n);
+                if ((net_node[i] == -1) && (H.nets()[i].size() > 1)) {
+                    net_node[i] = nodes;
+                    nodes += 2;
+                    nets.push_back(i);
+                }
+            }
+        }
+
+        long infinity = 1;
+        for (auto i : nets) {
+            infinity += H.nets()[i].cost();
+        }
+        auto network = pmondriaan::max_flow(nodes);
+        long cut_region = 0;
+        for (auto i : nets) {
+            auto& net = H.nets()[i];
+            auto in = net_node[i];
+            auto out = in + 1;
+            network.add_edge(in, out, net.cost());
+            if ((C[i][0] > 0) && (C[i][1] > 0)) {
+                cut_region += net.cost();
+            }
+            auto pin_outside = std::array<bool, 2>{false, false};
+            for (auto v : net.vertices()) {
+                auto local = H.local_id(v);
+                if (in_region[local]) {
+                    network.add_edge(node[local], in, infinity);
+                    network.add_edge(out, node[local], infinity);
+                } else {
+                    pin_outside[H(local).part()] = true;
+                }
+            }
+            if (pin_outside[0]) {
+                network.add_edge(0, in, infinity);
+            }
+            if (pin_outside[1]) {
+                network.add_edge(out, 1, infinity);
+            }
+        }
+
+        auto flow = network.compute(0, 1);
+        auto source_side_min = network.reachable_from(0);
+        auto sink_side_max = network.reaching(1);
+
+        /* Of the minimum cuts closest to the source and to the sink, the
+           balanced one whose weights are closest to the ratio of the maximum
+           weights is used. */
+        auto best = -1;
+        long best_imbalance = 0;
+        auto new_weights = std::array<std::array<long, 2>, 2>();
+        for (auto c = 0; c < 2; c++) {
+            long weight_0 = weights[0] - region_weight[0];
+            for (auto local : region) {
+                if ((c == 0) ? source_side_min[node[local]] : !sink_side_max[node[local]]) {
+                    weight_0 += H(local).weight();
+                }
+            }
+            new_weights[c] = {weight_0, total_weight - weight_0};
+            auto imbalance = std::abs(new_weights[c][0] * max_weight_1 -
+                                      new_weights[c][1] * max_weight_0);
+            if ((new_weights[c][0] <= max_weight_0) && (new_weights[c][1] <= max_weight_1) &&
+                ((best == -1) || (imbalance < best_imbalance))) {
+                best = c;
+                best_imbalance = imbalance;
+            }
+        }
+
+        if ((flow < cut_region) && (best >= 0)) {
+            for (auto local : region) {
+                auto part = ((best == 0) ? source_side_min[node[local]]
+                                         : !sink_side_max[node[local]]) ? 0 : 1;
+                auto& v = H(local);
+                if (v.part() != part) {
+                    for (auto n : v.nets()) {
+                        C[H.local_id_net(n)][v.part()]--;
+                        C[H.local_id_net(n)][part]++;
+                    }
+                    v.set_part(part);
+                }
+            }
+            weights[0] = new_weights[best][0];
+            weights[1] = new_weights[best][1];
+            cut_size -= cut_region - flow;
+        } else if (flow < cut_region) {
+            // a smaller region makes balanced cuts more likely
+            alpha /= 2.0;
+        }
+
+        for (auto local : region) {
+            in_region[local] = false;
+            node[local] = -1;
+        }
+        for (auto i : nets) {
+            net_node[i] = -1;
+        }
+        if (flow >= cut_region) {
+            break;
+        }
+    }
+    return cut_size;
+}
+
+} // namespace pmondriaan
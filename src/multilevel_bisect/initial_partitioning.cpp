@@ -1,4 +1,11 @@
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <limits>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
 
 #include <bulk/bulk.hpp>
 #ifdef BACKEND_MPI
@@ -10,6 +17,7 @@
 #include "bisect.hpp"
 #include "hypergraph/hypergraph.hpp"
 #include "multilevel_bisect/KLFM/KLFM.hpp"
+#include "multilevel_bisect/KLFM/gain_buckets.hpp"
 #include "multilevel_bisect/initial_partitioning.hpp"
 #include "multilevel_bisect/label_propagation.hpp"
 
@@ -23,45 +31,108 @@ long initial_partitioning(pmondriaan::hypergraph& H,
                           long max_weight_1,
                           pmondriaan::options& opts,
                           std::mt19937& rng) {
+    return initial_partitioning_attempts(H, max_weight_0, max_weight_1, opts, rng, 0, 1);
+}
+
+/**
+ * Creates an initial partitioning for hypergraph H, where the attempts are
+ * divided over all processors. Returns the cutsize of the solution found by this processor.
+ */
+long initial_partitioning(bulk::world& world,
+                          pmondriaan::hypergraph& H,
+                          long max_weight_0,
+                          long max_weight_1,
+                          pmondriaan::options& opts,
+                          std::mt19937& rng) {
+    return initial_partitioning_attempts(H, max_weight_0, max_weight_1, opts, rng,
+                                         world.rank(), world.active_processors());
+}
 
-    // pmondriaan::interval labels = {0,1};
-    // bisect_random(H, max_weight_0, max_weight_1, 0, H.size(), labels, rng);
+/**
+ * Creates an initial partitioning for hypergraph H using the attempts
+ * first, first + step, ... of the attempt budget. Every call makes at least
+ * one attempt. The attempts are run concurrently by opts.threads threads,
+ * each working on its own copy of H. Returns the cutsize of the solution found.
+ */
+long initial_partitioning_attempts(pmondriaan::hypergraph& H,
+                                   long max_weight_0,
+                                   long max_weight_1,
+                                   pmondriaan::options& opts,
+                                   std::mt19937& rng,
+                                   long first,
+                                   long step) {
 
     auto L_best = std::vector<long>(H.size());
     long best_cut = std::numeric_limits<long>::max();
     long best_imbalance = std::numeric_limits<long>::max();
-    auto time = bulk::util::timer();
-    
-    for (long i = 0; i < 10; i++) {
-        time.get();
-        // counts of all labels for each net
-        auto C =
-        std::vector<std::vector<long>>(H.nets().size(), std::vector<long>(2, 0));
-
-        auto L = label_propagation_bisect(H, C, opts.lp_max_iterations,
-                                          max_weight_0, max_weight_1, rng);
-        for (auto i = 0u; i < H.size(); i++) {
-            H(i).set_part(L[i]);
-        }
+    // the last attempt of this processor that improved the best solution
+    long last_improvement = -1;
+    std::mutex best_mutex;
 
-        // std::cout << "time lp: " << time.get_change() << "(round " << i << ")\n";
+    auto attempts = std::max((long)opts.initial_attempts, first + 1);
+    // the number of attempts of this processor, which are handed out to the threads in order
+    long nr_attempts = (attempts - first + step - 1) / step;
+    std::atomic<long> next_attempt(0);
 
-        auto cut = pmondriaan::KLFM(H, C, H.weight_part(0), H.weight_part(1),
-                                    max_weight_0, max_weight_1, opts, rng);
+    auto run_attempts = [&](pmondriaan::hypergraph& H_t, std::mt19937& rng_t) {
+        // counts of all labels for each net, and the scratch space of the label
+        // propagation, which are reused by the attempts of this thread
+        auto C = std::vector<std::vector<long>>(H_t.nets().size(), std::vector<long>(2, 0));
+        auto scratch = pmondriaan::lp_bisect_scratch();
+        for (auto j = next_attempt++; j < nr_attempts; j = next_attempt++) {
+            {
+                // we stop early if the last attempts did not improve a balanced solution
+                std::lock_guard<std::mutex> lock(best_mutex);
+                if ((opts.initial_max_no_improvement > 0) && (best_imbalance <= 0) &&
+                    (j - last_improvement > (long)opts.initial_max_no_improvement)) {
+                    return;
+                }
+            }
+
+            for (auto& counts : C) {
+                counts[0] = 0;
+                counts[1] = 0;
+            }
+            auto L = initial_bisect(H_t, C, initial_algorithm(opts.initial_mode, first + j * step),
+                                    max_weight_0, max_weight_1, opts, rng_t, &scratch);
+            for (auto i = 0u; i < H_t.size(); i++) {
+                H_t(i).set_part(L[i]);
+            }
 
-        // std::cout << "time KLFM: " << time.get_change() << "(round " << i << ")\n";
+            auto cut = pmondriaan::KLFM(H_t, C, H_t.weight_part(0), H_t.weight_part(1),
+                                        max_weight_0, max_weight_1, opts, rng_t);
 
-        long imbalance =
-        std::max(H.weight_part(0) - max_weight_0, H.weight_part(1) - max_weight_1);
+            long imbalance =
+            std::max(H_t.weight_part(0) - max_weight_0, H_t.weight_part(1) - max_weight_1);
 
-        if (((cut < best_cut) && (imbalance <= 0)) ||
-            (((cut == best_cut) || (best_imbalance > 0)) && (imbalance < best_imbalance))) {
-            for (auto i = 0u; i < H.size(); i++) {
-                L_best[i] = H(i).part();
+            std::lock_guard<std::mutex> lock(best_mutex);
+            if (((cut < best_cut) && (imbalance <= 0)) ||
+                (((cut == best_cut) || (best_imbalance > 0)) && (imbalance < best_imbalance))) {
+                for (auto i = 0u; i < H_t.size(); i++) {
+                    L_best[i] = H_t(i).part();
+                }
+                best_cut = cut;
+                best_imbalance = imbalance;
+                last_improvement = j;
             }
-            best_cut = cut;
-            best_imbalance = imbalance;
         }
+    };
+
+    // the calling thread works on H itself, the other threads on copies
+    auto nr_threads = std::max(1l, std::min((long)opts.threads, nr_attempts));
+    auto H_copies = std::vector<pmondriaan::hypergraph>();
+    auto rngs = std::vector<std::mt19937>();
+    for (long t = 1; t < nr_threads; t++) {
+        H_copies.push_back(H);
+        rngs.push_back(std::mt19937(rng()));
+    }
+    auto threads = std::vector<std::thread>();
+    for (long t = 1; t < nr_threads; t++) {
+        threads.emplace_back(run_attempts, std::ref(H_copies[t - 1]), std::ref(rngs[t - 1]));
+    }
+    run_attempts(H, rng);
+    for (auto& thread : threads) {
+        thread.join();
     }
 
     for (auto i = 0u; i < H.size(); i++) {
@@ -71,5 +142,161 @@ long initial_partitioning(pmondriaan::hypergraph& H,
     return best_cut;
 }
 
+/**
+ * Returns the algorithm used in the given attempt. A portfolio cycles
+ * through all algorithms, so that processors run different algorithms.
+ */
+pmondriaan::initial initial_algorithm(pmondriaan::initial mode, long attempt) {
+    if (mode != pmondriaan::initial::portfolio) {
+        return mode;
+    }
+    constexpr pmondriaan::initial portfolio[] = {pmondriaan::initial::label_propagation,
+                                                 pmondriaan::initial::ghg,
+                                                 pmondriaan::initial::bfs,
+                                                 pmondriaan::initial::random};
+    return portfolio[attempt % 4];
+}
+
+/**
+ * Bisects H using the given algorithm, without refinement. Returns the
+ * labels of the vertices and fills C with the counts of the labels for each net.
+ */
+std::vector<long> initial_bisect(pmondriaan::hypergraph& H,
+                                 std::vector<std::vector<long>>& C,
+                                 pmondriaan::initial algorithm,
+                                 long max_weight_0,
+                                 long max_weight_1,
+                                 pmondriaan::options& opts,
+                                 std::mt19937& rng,
+                                 pmondriaan::lp_bisect_scratch* scratch) {
+    if (algorithm == pmondriaan::initial::label_propagation) {
+        return label_propagation_bisect(H, C, opts.lp_max_iterations, max_weight_0,
+                                        max_weight_1, rng, scratch);
+    }
+
+    auto L = std::vector<long>();
+    if (algorithm == pmondriaan::initial::ghg) {
+        L = ghg_bisect(H, max_weight_0, max_weight_1, rng);
+    } else if (algorithm == pmondriaan::initial::bfs) {
+        L = bfs_bisect(H, max_weight_0, max_weight_1, rng);
+    } else {
+        L = random_bisect(H, max_weight_0, max_weight_1, rng);
+    }
+    for (auto i = 0u; i < H.size(); i++) {
+        for (auto n : H(i).nets()) {
+            C[H.local_id_net(n)][L[i]]++;
+        }
+    }
+    return L;
+}
+
+/**
+ * Bisects H randomly under the balance constraint. Returns the labels of the vertices.
+ */
+std::vector<long>
+random_bisect(pmondriaan::hypergraph& H, long max_weight_0, long max_weight_1, std::mt19937& rng) {
+    auto L = std::vector<long>(H.size());
+    // the weight that can still be assigned to the parts
+    auto weight_L = std::vector<long>{max_weight_0, max_weight_1};
+    for (auto i = 0u; i < H.size(); i++) {
+        L[i] = rng() % 2;
+        if ((weight_L[L[i]] - H(i).weight()) < 0) {
+            L[i] = (L[i] + 1) % 2;
+        }
+        weight_L[L[i]] -= H(i).weight();
+    }
+    return L;
+}
+
+/**
+ * Bisects H by greedy hypergraph growing: starting with all vertices in part 1
+ * and a random seed vertex in part 0, the vertex with the highest FM gain is
+ * moved to part 0 until part 0 has its share of the total weight. Returns the
+ * labels of the vertices.
+ */
+std::vector<long>
+ghg_bisect(pmondriaan::hypergraph& H, long max_weight_0, long max_weight_1, std::mt19937& rng) {
+    auto L = std::vector<long>(H.size(), 1);
+    if (H.size() == 0) {
+        return L;
+    }
+    auto target_0 = (long)((double)H.total_weight() * (double)max_weight_0 /
+                           (double)(max_weight_0 + max_weight_1));
+
+    for (auto& v : H.vertices()) {
+        v.set_part(1);
+    }
+    auto C = init_counts(H);
+    auto gain_structure = pmondriaan::gain_structure(H, C);
+
+    // the seed is moved first, after that the gains of its neighbours are the highest
+    long weight_0 = 0;
+    auto next = H(rng() % H.size()).id();
+    while ((next != -1) && (weight_0 < target_0)) {
+        auto weight = H(H.local_id(next)).weight();
+        if (weight_0 + weight <= max_weight_0) {
+            gain_structure.move(next);
+            L[H.local_id(next)] = 0;
+            weight_0 += weight;
+        } else {
+            gain_structure.remove(next);
+        }
+        next = gain_structure.next(1);
+    }
+    return L;
+}
+
+/**
+ * Bisects H by growing part 0 in breadth-first order from a random vertex,
+ * until it has its share of the total weight. Returns the labels of the vertices.
+ */
+std::vector<long>
+bfs_bisect(pmondriaan::hypergraph& H, long max_weight_0, long max_weight_1, std::mt19937& rng) {
+    auto L = std::vector<long>(H.size(), 1);
+    if (H.size() == 0) {
+        return L;
+    }
+    auto target_0 = (long)((double)H.total_weight() * (double)max_weight_0 /
+                           (double)(max_weight_0 + max_weight_1));
+
+    auto visited = std::vector<bool>(H.size(), false);
+    auto queue = std::queue<long>();
+    long weight_0 = 0;
+    long nr_visited = 0;
+    while (weight_0 < target_0) {
+        if (queue.empty()) {
+            // we start a new search in an unvisited part of the hypergraph
+            if (nr_visited == (long)H.size()) {
+                break;
+            }
+            auto start = (long)(rng() % H.size());
+            while (visited[start]) {
+                start = (start + 1) % H.size();
+            }
+            visited[start] = true;
+            nr_visited++;
+            queue.push(start);
+        }
+
+        auto v = queue.front();
+        queue.pop();
+        if (weight_0 + H(v).weight() > max_weight_0) {
+            continue;
+        }
+        L[v] = 0;
+        weight_0 += H(v).weight();
+        for (auto n : H(v).nets()) {
+            for (auto u_id : H.net(n).vertices()) {
+                auto u = H.local_id(u_id);
+                if (!visited[u]) {
+                    visited[u] = true;
+                    nr_visited++;
+                    queue.push(u);
+                }
+            }
+        }
+    }
+    return L;
+}
 
 } // namespace pmondriaan
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+#else
+#include <bulk/backends/thread/thread.hpp>
+#endif
+
+#include "hypergraph/hypergraph.hpp"
+#include "multilevel_bisect/jet.hpp"
+#include "multilevel_bisect/parallel_counts.hpp"
+
+namespace pmondriaan {
+
+namespace {
+
+constexpr int nr_rebalance_buckets = 32;
+
+/**
+ * The bucket of a vertex in the rebalancing, vertices with a smaller loss per
+ * unit of weight are in a lower bucket.
+ */
+int rebalance_bucket(long gain, long weight) {
+    if ((gain >= 0) || (weight <= 0)) {
+        return 0;
+    }
+    auto loss = (double)(-gain) / (double)weight;
+    auto index = 1 + (int)std::floor(std::log2(loss)) + (nr_rebalance_buckets / 2);
+    return std::clamp(index, 1, nr_rebalance_buckets - 1);
+}
+
+} // namespace
+
+/**
+ * Refines a bisection of the distributed hypergraph H in the style of Jet.
+ */
+long jet_refine_par(bulk::world& world,
+                    pmondriaan::hypergraph& H,
+                    std::vector<std::vector<long>>& C,
+                    long weight_0,
+                    long weight_1,
+                    long max_weight_0,
+                    long max_weight_1,
+                    pmondriaan::options& opts,
+                    long cut_size,
+                    pmondriaan::net_directory* directory) {
+    auto s = world.rank();
+    auto p = world.active_processors();
+    auto counts = pmondriaan::parallel_counts(world, H, C, directory);
+    if (cut_size == std::numeric_limits<long>::max()) {
+        cut_size = counts.cut_size();
+    }
+
+    auto total_weights = std::array<long, 2>{weight_0, weight_1};
+    auto max_weights = std::array<long, 2>{max_weight_0, max_weight_1};
+    auto excess = [&]() {
+        return std::max(0l, total_weights[0] - max_weights[0]) +
+               std::max(0l, total_weights[1] - max_weights[1]);
+    };
+
+    auto best_cut = cut_size;
+    auto best_excess = excess();
+    auto best_parts = std::vector<long>(H.size());
+    for (auto i = 0u; i < H.size(); i++) {
+        best_parts[i] = H(i).part();
+    }
+    auto current_is_best = true;
+
+    // (net, vertex, gain, part, processor) of the candidates, sent to the owner of the net
+    auto proposals = bulk::queue<long, long, long, long, int>(world);
+    // (vertex, net, number of moves with higher priority out of the part of
+    // the vertex minus the number into it)
+    auto shifts = bulk::queue<long, long, long>(world);
+
+    // vertices moved in the previous iteration may not move back immediately
+    auto locked = std::vector<bool>(H.size(), false);
+    auto moved = std::vector<long>();
+    auto after_gain = std::vector<long>(H.size(), 0);
+
+    size_t no_improvement = 0;
+    size_t unchanged = 0;
+    while ((no_improvement < opts.jet_max_no_improvement) && (unchanged < 2)) {
+        // all vertices whose move loses little are candidates
+        auto candidates = std::vector<long>();
+        for (auto i : counts.boundary()) {
+            if (locked[i]) {
+                continue;
+            }
+            auto& v = H(i);
+            long connected = 0;
+            for (auto n : v.nets()) {
+                if (C[H.local_id_net(n)][v.part()] > 1) {
+                    connected += H.net(n).cost();
+                }
+            }
+            auto gain = counts.gain(i);
+            if ((gain > 0) || ((double)(-gain) < opts.jet_negative_gain_factor * (double)connected)) {
+                candidates.push_back(i);
+                after_gain[i] = gain;
+                for (auto n : v.nets()) {
+                    proposals(counts.owner(n)).send(n, v.id(), gain, v.part(), s);
+                }
+            }
+        }
+        world.sync();
+
+        // afterburner: the owner of a net orders its candidates on priority and
+        // tells each candidate how the moves before it change the counts
+        auto received = std::vector<std::tuple<long, long, long, long, int>>();
+        for (const auto& [n, id, gain, part, t] : proposals) {
+            received.push_back({n, -gain, id, part, t});
+        }
+        std::sort(received.begin(), received.end());
+        auto moves_out = std::array<long, 2>{0, 0};
+        for (auto j = 0u; j < received.size(); j++) {
+            const auto& [n, neg_gain, id, part, t] = received[j];
+            if ((j == 0) || (std::get<0>(received[j - 1]) != n)) {
+                moves_out = {0, 0};
+            }
+            shifts(t).send(id, n, moves_out[part] - moves_out[(part + 1) % 2]);
+            moves_out[part]++;
+        }
+        world.sync();
+
+        for (auto i : candidates) {
+            after_gain[i] = 0;
+        }
+        for (const auto& [id, n, shift] : shifts) {
+            auto i = H.local_id(id);
+            auto from = H(i).part();
+            auto to = (from + 1) % 2;
+            auto& net_counts = C[H.local_id_net(n)];
+            if (net_counts[from] - shift == 1) {
+                after_gain[i] += H.net(n).cost();
+            }
+            if (net_counts[to] + shift == 0) {
+                after_gain[i] -= H.net(n).cost();
+            }
+        }
+
+        for (auto i : moved) {
+            locked[i] = false;
+        }
+        moved.clear();
+        long weight_change = 0;
+        for (auto i : candidates) {
+            if (after_gain[i] > 0) {
+                weight_change += counts.move(i);
+                moved.push_back(i);
+                locked[i] = true;
+            }
+        }
+        auto result = counts.synchronize(weight_change);
+        auto new_cut_size = result[0];
+        total_weights[0] += result[1];
+        total_weights[1] -= result[1];
+        auto changed = (new_cut_size != cut_size) || (result[1] != 0);
+
+        // rebalancing: the heavy part moves the vertices with the smallest loss
+        // per unit of weight, the processors agree on the buckets that move
+        if (excess() > 0) {
+            auto heavy = (total_weights[0] > max_weights[0]) ? 0 : 1;
+            auto light = (heavy + 1) % 2;
+            auto needed = total_weights[heavy] - max_weights[heavy];
+            auto room = max_weights[light] - total_weights[light];
+
+            auto rebalance_candidates = std::vector<std::tuple<double, int, long>>();
+            auto bucket_weights = std::array<long, nr_rebalance_buckets>();
+            bucket_weights.fill(0);
+            for (auto i = 0u; i < H.size(); i++) {
+                auto& v = H(i);
+                if ((v.part() != heavy) || (v.weight() > room)) {
+                    continue;
+                }
+                auto gain = counts.gain(i);
+                auto bucket = rebalance_bucket(gain, v.weight());
+                auto loss = (v.weight() > 0) ? (double)(-gain) / (double)v.weight() : 0.0;
+                rebalance_candidates.push_back({loss, bucket, i});
+                bucket_weights[bucket] += v.weight();
+            }
+
+            auto all_bucket_weights = bulk::gather_all(world, bucket_weights);
+            auto last_bucket = nr_rebalance_buckets;
+            long share = 0;
+            long cumulative = 0;
+            for (auto b = 0; b < nr_rebalance_buckets; b++) {
+                long bucket_total = 0;
+                for (auto t = 0; t < p; t++) {
+                    bucket_total += all_bucket_weights[t][b];
+                }
+                if (cumulative + bucket_total >= needed) {
+                    // the last bucket is divided proportionally over the processors
+                    last_bucket = b;
+                    share = ((needed - cumulative) * bucket_weights[b] + bucket_total - 1) / bucket_total;
+                    break;
+                }
+                cumulative += bucket_total;
+            }
+
+            std::stable_sort(rebalance_candidates.begin(), rebalance_candidates.end());
+            weight_change = 0;
+            long used = 0;
+            for (const auto& candidate : rebalance_candidates) {
+                auto bucket = std::get<1>(candidate);
+                auto i = std::get<2>(candidate);
+                if ((bucket < last_bucket) || ((bucket == last_bucket) && (used < share))) {
+                    if (bucket == last_bucket) {
+                        used += H(i).weight();
+                    }
+                    weight_change += counts.move(i);
+                    moved.push_back(i);
+                    locked[i] = true;
+                }
+            }
+            result = counts.synchronize(weight_change);
+            new_cut_size = result[0];
+            total_weights[0] += result[1];
+            total_weights[1] -= result[1];
+            changed = true;
+        }
+        cut_size = new_cut_size;
+
+        if ((excess() < best_excess) || ((excess() == best_excess) && (cut_size < best_cut))) {
+            best_cut = cut_size;
+            best_excess = excess();
+            for (auto i = 0u; i < H.size(); i++) {
+                best_parts[i] = H(i).part();
+            }
+            current_is_best = true;
+            no_improvement = 0;
+        } else {
+            current_is_best = (excess() == best_excess) && (cut_size == best_cut);
+            no_improvement++;
+        }
+        unchanged = changed ? 0 : unchanged + 1;
+    }
+
+    // go back to the best solution found
+    if (!current_is_best) {
+        long weight_change = 0;
+        for (auto i = 0u; i < H.size(); i++) {
+            if (H(i).part() != best_parts[i]) {
+                weight_change += counts.move(i);
+            }
+        }
+        counts.synchronize(weight_change);
+    }
+
+    return best_cut;
+}
+
+} // namespace pmondriaan
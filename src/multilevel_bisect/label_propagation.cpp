@@ -1,19 +1,35 @@
 #include <algorithm>
+#include <array>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <utility>
 #include <vector>
 
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+#else
+#include <bulk/backends/thread/thread.hpp>
+#endif
+
 #include "hypergraph/hypergraph.hpp"
+#include "kway_refinement.hpp"
 #include "multilevel_bisect/label_propagation.hpp"
+#include "multilevel_bisect/parallel_counts.hpp"
 
 namespace pmondriaan {
 
 /**
  * Performs label propagation to create l groups of labels on the hypergraph H.
+ * Every net only stores the labels present in it, so the memory and the time
+ * per iteration are linear in the number of pins instead of in the number of
+ * nets times l.
  */
 std::vector<long>
 label_propagation(pmondriaan::hypergraph& H, long l, long max_iter, long min_size, std::mt19937& rng) {
-    // counts of all labels for each net
-    auto C = std::vector<std::vector<long>>(H.nets().size(), std::vector<long>(l, 0));
+    // the labels present in each net with their counts, sorted by label
+    auto C = std::vector<std::vector<std::pair<long, long>>>(H.nets().size());
     auto size_L = std::vector<long>(l, 0);
     // the labels of the vertices
     auto L = std::vector<long>(H.size());
@@ -23,14 +39,30 @@ label_propagation(pmondriaan::hypergraph& H, long l, long max_iter, long min_siz
         L[i] = random % l;
         size_L[L[i]]++;
         for (auto n : H(i).nets()) {
-            C[H.local_id_net(n)][L[i]]++;
+            C[H.local_id_net(n)].push_back({L[i], 1});
+        }
+    }
+    // the pins with the same label are merged into one pair
+    for (auto& counts : C) {
+        std::sort(counts.begin(), counts.end());
+        auto size = 0u;
+        for (auto j = 0u; j < counts.size(); j++) {
+            if ((size > 0) && (counts[size - 1].first == counts[j].first)) {
+                counts[size - 1].second += counts[j].second;
+            } else {
+                counts[size++] = counts[j];
+            }
         }
+        counts.resize(size);
     }
 
     std::vector<long> indices(H.size());
     std::iota(indices.begin(), indices.end(), 0);
 
-    auto T = std::vector<long>(l);
+    // the scores of the labels present in the nets of a vertex, all other scores are 0
+    auto T = std::vector<long>(l, 0);
+    auto present = std::vector<long>();
+    auto label_max = std::vector<long>();
     bool change = true;
     long iterations = 0;
 
@@ -38,44 +70,54 @@ label_propagation(pmondriaan::hypergraph& H, long l, long max_iter, long min_siz
         std::shuffle(indices.begin(), indices.end(), rng);
         change = false;
         for (auto i : indices) {
-            std::fill(T.begin(), T.end(), 0);
-
             if (size_L[L[i]] > min_size) {
-                // First compute the sum of the counts
+                // First compute the sum of the counts, without the vertex itself
                 for (auto n : H(i).nets()) {
-                    C[H.local_id_net(n)][L[i]]--;
-                    for (long j = 0; j < l; j++) {
-                        T[j] += C[H.local_id_net(n)][j];
+                    for (const auto& [label, count] : C[H.local_id_net(n)]) {
+                        if (T[label] == 0) {
+                            present.push_back(label);
+                        }
+                        T[label] += count;
                     }
                 }
+                T[L[i]] -= H(i).degree();
 
-                // Now compute argmax(T), where we break ties randomly
-                long max = -1;
-                auto label_max = std::vector<long>();
-                for (long j = 0; j < l; j++) {
-                    if (T[j] == max) {
-                        label_max.push_back(j);
-                    } else if (T[j] > max) {
-                        max = T[j];
+                // Now compute argmax(T), where we break ties randomly. If no
+                // label has a positive score, all labels are tied.
+                long max = 0;
+                label_max.clear();
+                for (auto label : present) {
+                    if (T[label] > max) {
+                        max = T[label];
                         label_max.clear();
-                        label_max.push_back(j);
+                        label_max.push_back(label);
+                    } else if ((T[label] == max) && (max > 0)) {
+                        label_max.push_back(label);
                     }
+                    T[label] = 0;
                 }
+                present.clear();
 
                 // Set new label and change if it is changed
                 auto random = rng();
-                long new_label = label_max[random % label_max.size()];
+                long new_label;
+                if (label_max.empty()) {
+                    new_label = random % l;
+                } else {
+                    std::sort(label_max.begin(), label_max.end());
+                    new_label = label_max[random % label_max.size()];
+                }
                 if (new_label != L[i]) {
                     change = true;
+                    for (auto n : H(i).nets()) {
+                        auto& counts = C[H.local_id_net(n)];
+                        pmondriaan::add_count(counts, L[i], -1);
+                        pmondriaan::add_count(counts, new_label, 1);
+                    }
                     size_L[L[i]]--;
                     L[i] = new_label;
                     size_L[L[i]]++;
                 }
-
-                // Update the counts
-                for (auto n : H(i).nets()) {
-                    C[H.local_id_net(n)][L[i]]++;
-                }
             }
         }
         iterations++;
@@ -84,19 +126,46 @@ label_propagation(pmondriaan::hypergraph& H, long l, long max_iter, long min_siz
     return L;
 }
 
+void lp_bisect_scratch::prepare(pmondriaan::hypergraph& H) {
+    if (offsets.size() != H.size() + 1) {
+        offsets.assign(1, 0);
+        pins.clear();
+        for (auto i = 0u; i < H.size(); i++) {
+            for (auto n : H(i).nets()) {
+                pins.push_back(H.local_id_net(n));
+            }
+            offsets.push_back(pins.size());
+        }
+        indices.resize(H.size());
+    }
+    counts.assign(2 * H.nets().size(), 0);
+    std::iota(indices.begin(), indices.end(), 0);
+}
+
+/**
+ * Bisects H by size-constrained label propagation with at most max_iter
+ * iterations. Returns the labels of the vertices and adds the counts of the
+ * labels of each net to C. The scratch space is reused if it is given.
+ */
 std::vector<long> label_propagation_bisect(pmondriaan::hypergraph& H,
                                            std::vector<std::vector<long>>& C,
                                            long max_iter,
                                            long max_weight_0,
                                            long max_weight_1,
-                                           std::mt19937& rng) {
+                                           std::mt19937& rng,
+                                           pmondriaan::lp_bisect_scratch* scratch) {
+    auto own_scratch = pmondriaan::lp_bisect_scratch();
+    auto& work = (scratch != nullptr) ? *scratch : own_scratch;
+    work.prepare(H);
+    auto& offsets = work.offsets;
+    auto& pins = work.pins;
+    // the counts of label 0 and 1 of net n are stored at 2n and 2n + 1
+    auto& counts = work.counts;
 
     // The labels of the vertices
     auto L = std::vector<long>(H.size());
     // Stores that weight that can still be assigned to the labels
-    auto weight_L = std::vector<long>(2, 0);
-    weight_L[0] = max_weight_0;
-    weight_L[1] = max_weight_1;
+    long weight_L[2] = {max_weight_0, max_weight_1};
 
     for (auto i = 0u; i < H.size(); i++) {
         auto random = rng();
@@ -105,65 +174,158 @@ std::vector<long> label_propagation_bisect(pmondriaan::hypergraph& H,
             L[i] = (L[i] + 1) % 2;
         }
         weight_L[L[i]] -= H(i).weight();
-        for (auto n : H(i).nets()) {
-            C[H.local_id_net(n)][L[i]]++;
+        for (auto j = offsets[i]; j < offsets[i + 1]; j++) {
+            counts[2 * pins[j] + L[i]]++;
         }
     }
 
-    std::vector<long> indices(H.size());
-    std::iota(indices.begin(), indices.end(), 0);
-
-    auto T = std::vector<long>(2);
+    auto& indices = work.indices;
     bool change = true;
     long iterations = 0;
     while (change && (iterations < max_iter)) {
         std::shuffle(indices.begin(), indices.end(), rng);
         change = false;
         for (auto i : indices) {
-            std::fill(T.begin(), T.end(), 0);
+            // the number of other pins with each label in the nets of i
+            long T[2] = {0, 0};
+            for (auto j = offsets[i]; j < offsets[i + 1]; j++) {
+                T[0] += counts[2 * pins[j]];
+                T[1] += counts[2 * pins[j] + 1];
+            }
+            T[L[i]] -= offsets[i + 1] - offsets[i];
 
-            // First compute the sum of the counts
-            for (auto n : H(i).nets()) {
-                C[H.local_id_net(n)][L[i]]--;
-                for (long j = 0; j < 2; j++) {
-                    T[j] += C[H.local_id_net(n)][j];
+            // the label with the highest score, where ties are broken randomly
+            auto random = rng();
+            long new_label = (T[1] > T[0]) | ((T[1] == T[0]) & (long)(random % 2));
+            if ((new_label != L[i]) && ((weight_L[new_label] - H(i).weight()) >= 0)) {
+                change = true;
+                weight_L[L[i]] += H(i).weight();
+                for (auto j = offsets[i]; j < offsets[i + 1]; j++) {
+                    counts[2 * pins[j] + L[i]]--;
+                    counts[2 * pins[j] + new_label]++;
                 }
+                L[i] = new_label;
+                weight_L[L[i]] -= H(i).weight();
             }
+        }
+        iterations++;
+    }
 
-            // Now compute argmax(T), where we break ties randomly
-            long max = -1;
-            auto label_max = std::vector<long>();
-            for (long j = 0; j < 2; j++) {
-                if (T[j] == max) {
-                    label_max.push_back(j);
-                } else if (T[j] > max) {
-                    max = T[j];
-                    label_max.clear();
-                    label_max.push_back(j);
-                }
+    for (auto n = 0u; n < H.nets().size(); n++) {
+        C[n][0] += counts[2 * n];
+        C[n][1] += counts[2 * n + 1];
+    }
+    return L;
+}
+
+/**
+ * Refines a bisection of the distributed hypergraph H by size-constrained
+ * label propagation. Returns the cutsize of the solution found.
+ */
+long label_propagation_refine_par(bulk::world& world,
+                                  pmondriaan::hypergraph& H,
+                                  std::vector<std::vector<long>>& C,
+                                  long weight_0,
+                                  long weight_1,
+                                  long max_weight_0,
+                                  long max_weight_1,
+                                  pmondriaan::options& opts,
+                                  std::mt19937& rng,
+                                  long cut_size,
+                                  pmondriaan::net_directory* directory) {
+    auto p = world.active_processors();
+    auto counts = pmondriaan::parallel_counts(world, H, C, directory);
+    if (cut_size == std::numeric_limits<long>::max()) {
+        cut_size = counts.cut_size();
+    }
+
+    auto total_weights = std::array<long, 2>{weight_0, weight_1};
+    auto max_weights = std::array<long, 2>{max_weight_0, max_weight_1};
+
+    for (size_t round = 0; round < opts.lp_max_iterations; round++) {
+        // only the vertices of cut nets can have a positive gain
+        auto boundary = counts.boundary();
+
+        // every processor proposes to move its vertices with positive gain, per part
+        auto candidates = std::array<std::vector<std::pair<long, long>>, 2>();
+        auto proposed = std::array<long, 2>{0, 0};
+        std::shuffle(boundary.begin(), boundary.end(), rng);
+        for (auto i : boundary) {
+            auto gain = counts.gain(i);
+            if (gain > 0) {
+                candidates[H(i).part()].push_back({gain, i});
+                proposed[H(i).part()] += H(i).weight();
             }
+        }
 
-            // Set new label and change if it is changed
-            if (max != -1) {
-                auto random = rng();
-                long new_label = label_max[random % label_max.size()];
-                if ((new_label != L[i]) && ((weight_L[new_label] - H(i).weight()) >= 0)) {
-                    change = true;
-                    weight_L[L[i]] += H(i).weight();
-                    L[i] = new_label;
-                    weight_L[L[i]] -= H(i).weight();
+        auto all_proposed = bulk::gather_all(world, proposed);
+        auto total_proposed = std::array<long, 2>{0, 0};
+        for (auto t = 0; t < p; t++) {
+            total_proposed[0] += all_proposed[t][0];
+            total_proposed[1] += all_proposed[t][1];
+        }
+        if (total_proposed[0] + total_proposed[1] == 0) {
+            break;
+        }
+
+        // the global budget of the weight that may leave each part, such that
+        // moves in the other direction keep the parts within their maximum weight
+        auto budget = std::array<long, 2>();
+        for (auto part = 0; part < 2; part++) {
+            auto other = (part + 1) % 2;
+            budget[part] =
+            std::max(0l, std::min(total_proposed[part], total_proposed[other] + max_weights[other] -
+                                                        total_weights[other]));
+        }
+
+        // every processor gets a share of the budget proportional to its proposals
+        long weight_change = 0;
+        auto moved = std::vector<long>();
+        for (auto part = 0; part < 2; part++) {
+            if (proposed[part] == 0) {
+                continue;
+            }
+            auto share = (long)((double)budget[part] * (double)proposed[part] /
+                                (double)total_proposed[part]);
+            std::stable_sort(candidates[part].begin(), candidates[part].end(),
+                             [](auto lhs, auto rhs) { return lhs.first > rhs.first; });
+            long used = 0;
+            for (const auto& candidate : candidates[part]) {
+                auto i = candidate.second;
+                if (used + H(i).weight() <= share) {
+                    used += H(i).weight();
+                    weight_change += counts.move(i);
+                    moved.push_back(i);
                 }
             }
+        }
 
-            // Update the counts
-            for (auto n : H(i).nets()) {
-                C[H.local_id_net(n)][L[i]]++;
+        auto balanced = (total_weights[0] <= max_weight_0) && (total_weights[1] <= max_weight_1);
+        auto result = counts.synchronize(weight_change);
+        auto new_cut_size = result[0];
+        total_weights[0] += result[1];
+        total_weights[1] -= result[1];
+
+        // moves based on outdated counts can conflict and the shares of the
+        // budget are rounded, so a round that is worse or unbalanced is undone
+        if ((new_cut_size > cut_size) ||
+            (balanced && ((total_weights[0] > max_weight_0) || (total_weights[1] > max_weight_1)))) {
+            weight_change = 0;
+            for (auto i : moved) {
+                weight_change += counts.move(i);
             }
+            result = counts.synchronize(weight_change);
+            total_weights[0] += result[1];
+            total_weights[1] -= result[1];
+            break;
         }
-        iterations++;
+        if (new_cut_size == cut_size) {
+            break;
+        }
+        cut_size = new_cut_size;
     }
 
-    return L;
+    return cut_size;
 }
 
-} // namespace pmondriaan
\ No newline at end of file
+} // namespace pmondriaan
@@ -0,0 +1,100 @@
+#include <array>
+#include <vector>
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+#else
+#include <bulk/backends/thread/thread.hpp>
+#endif
+
+#include "hypergraph/hypergraph.hpp"
+#include "multilevel_bisect/KLFM/KLFM_parallel.hpp"
+#include "multilevel_bisect/parallel_counts.hpp"
+
+namespace pmondriaan {
+
+parallel_counts::parallel_counts(bulk::world& world,
+                                 pmondriaan::hypergraph& H,
+                                 std::vector<std::vector<long>>& C,
+                                 pmondriaan::net_directory* directory)
+: world_(world), H_(H), C_(C),
+  directory_((directory != nullptr) ? *directory : own_directory_.emplace(world, H)),
+  previous_C_(directory_.local_count() * 2, 0), prev_C_0_(H.nets().size()),
+  update_nets_(world), changed_(H.nets().size()), in_boundary_(H.size(), false) {
+    cut_size_my_nets_ = init_previous_C(world, H, C, previous_C_, directory_);
+    for (auto i = 0u; i < H.nets().size(); i++) {
+        prev_C_0_[i] = C[i][0];
+    }
+}
+
+long parallel_counts::move(long i) {
+    auto& v = H_(i);
+    auto from = v.part();
+    auto to = (from + 1) % 2;
+    v.set_part(to);
+    for (auto n : v.nets()) {
+        C_[H_.local_id_net(n)][from]--;
+        C_[H_.local_id_net(n)][to]++;
+        changed_.insert(H_.local_id_net(n));
+    }
+    return (from == 0) ? -v.weight() : v.weight();
+}
+
+long parallel_counts::gain(long i) {
+    auto& v = H_(i);
+    auto from = v.part();
+    auto to = (from + 1) % 2;
+    long gain = 0;
+    for (auto n : v.nets()) {
+        auto& counts = C_[H_.local_id_net(n)];
+        if (counts[from] == 1) {
+            gain += H_.net(n).cost();
+        }
+        if (counts[to] == 0) {
+            gain -= H_.net(n).cost();
+        }
+    }
+    return gain;
+}
+
+std::vector<long> parallel_counts::boundary() {
+    auto result = std::vector<long>();
+    for (auto i = 0u; i < H_.nets().size(); i++) {
+        if ((C_[i][0] > 0) && (C_[i][1] > 0)) {
+            for (auto v : H_.nets()[i].vertices()) {
+                auto local = H_.local_id(v);
+                if (!in_boundary_[local]) {
+                    in_boundary_[local] = true;
+                    result.push_back(local);
+                }
+            }
+        }
+    }
+    for (auto i : result) {
+        in_boundary_[i] = false;
+    }
+    return result;
+}
+
+std::array<long, 2> parallel_counts::synchronize(long weight_change) {
+    for (auto i : changed_.nets()) {
+        if (prev_C_0_[i] != C_[i][0]) {
+            update_nets_(owner(H_.nets()[i].id())).send(H_.nets()[i].id(), C_[i][0]);
+        }
+    }
+    world_.sync();
+    cut_size_my_nets_ = update_C(world_, H_, C_, previous_C_, prev_C_0_, update_nets_, directory_,
+                                 cut_size_my_nets_, changed_, nullptr);
+    auto results = bulk::gather_all(world_, std::array<long, 2>{cut_size_my_nets_, weight_change});
+    auto result = std::array<long, 2>{0, 0};
+    for (auto t = 0; t < world_.active_processors(); t++) {
+        result[0] += results[t][0];
+        result[1] += results[t][1];
+    }
+    return result;
+}
+
+long parallel_counts::cut_size() { return bulk::sum(world_, cut_size_my_nets_); }
+
+} // namespace pmondriaan
@@ -1,3 +1,4 @@
+#include <limits>
 #include <random>
 #include <unordered_map>
 #include <vector>
@@ -11,16 +12,20 @@
 
 #include "hypergraph/contraction.hpp"
 #include "hypergraph/hypergraph.hpp"
+#include "hypergraph/net_directory.hpp"
 #include "multilevel_bisect/KLFM/KLFM.hpp"
 #include "multilevel_bisect/KLFM/KLFM_parallel.hpp"
+#include "multilevel_bisect/flow_refinement.hpp"
+#include "multilevel_bisect/jet.hpp"
+#include "multilevel_bisect/label_propagation.hpp"
 #include "multilevel_bisect/uncoarsen.hpp"
 
 namespace pmondriaan {
 
 /**
  * Uncoarsens the hypergraph HC sequentially into the hypergraph H.
- * The cutsize is then optimized using the KLFM algorithm. Returns
- * the cutsize of the partitioning found.
+ * The cutsize is then optimized using the flow refinement if enabled and the
+ * KLFM algorithm. Returns the cutsize of the partitioning found.
  */
 long uncoarsen_hypergraph_seq(pmondriaan::hypergraph& HC,
                               pmondriaan::hypergraph& H,
@@ -29,13 +34,19 @@ long uncoarsen_hypergraph_seq(pmondriaan::hypergraph& HC,
                               long max_weight_0,
                               long max_weight_1,
                               long cut_size,
-                              std::mt19937& rng) {
+                              std::mt19937& rng,
+                              pmondriaan::KLFM_statistics* stats) {
     // We first assign the free vertices of HC greedily such that the imbalance is minimized
     auto new_weights = C.assign_free_vertices(HC, max_weight_0, max_weight_1, rng);
     uncoarsen_hypergraph(HC, H, C);
     auto counts = pmondriaan::init_counts(H);
+    auto cut = std::numeric_limits<long>::max();
+    if (opts.flow_refinement) {
+        cut = flow_refine(H, counts, new_weights, max_weight_0, max_weight_1, opts,
+                          pmondriaan::cutsize(H, counts));
+    }
     return KLFM(H, counts, new_weights[0], new_weights[1], max_weight_0,
-                max_weight_1, opts, rng);
+                max_weight_1, opts, rng, cut, stats);
 }
 
 /**
@@ -51,13 +62,31 @@ long uncoarsen_hypergraph_par(bulk::world& world,
                               long max_weight_0,
                               long max_weight_1,
                               long cut_size,
-                              std::mt19937& rng) {
+                              std::mt19937& rng,
+                              pmondriaan::KLFM_statistics* stats) {
     // We first assign the free vertices of HC greedily such that the imbalance is minimized
     auto new_weights = C.assign_free_vertices(world, HC, max_weight_0, max_weight_1, rng);
     uncoarsen_hypergraph(world, HC, H, C);
-    auto counts = pmondriaan::init_counts(world, H);
+    // identical vertices end up in the same part, so the cutsize has not changed
+    if (C.identical()) {
+        return cut_size;
+    }
+    // the directory is shared by the counts and the refinement of this level
+    auto directory = pmondriaan::net_directory(world, H, opts.balance_net_ownership);
+    auto counts = pmondriaan::init_counts(world, H, directory);
+    if ((opts.refinement_par == pmondriaan::refinement::label_propagation) &&
+        (H.global_size() >= opts.refinement_min_size)) {
+        return label_propagation_refine_par(world, H, counts, new_weights[0], new_weights[1],
+                                            max_weight_0, max_weight_1, opts, rng, cut_size,
+                                            &directory);
+    }
+    if ((opts.refinement_par == pmondriaan::refinement::jet) &&
+        (H.global_size() >= opts.refinement_min_size)) {
+        return jet_refine_par(world, H, counts, new_weights[0], new_weights[1], max_weight_0,
+                              max_weight_1, opts, cut_size, &directory);
+    }
     return KLFM_par(world, H, counts, new_weights[0], new_weights[1],
-                    max_weight_0, max_weight_1, opts, rng, cut_size);
+                    max_weight_0, max_weight_1, opts, rng, cut_size, &directory, stats);
 }
 
 /**
@@ -1,5 +1,7 @@
 #include <algorithm>
 #include <cmath>
+#include <deque>
+#include <memory>
 #include <random>
 #include <stack>
 #include <stdlib.h>
@@ -12,9 +14,11 @@
 #include "algorithm.hpp"
 #include "bisect.hpp"
 #include "hypergraph/hypergraph.hpp"
+#include "kway_refinement.hpp"
 #include "options.hpp"
 #include "recursive_bisection.hpp"
 #include "util/interval.hpp"
+#include "util/job_pool.hpp"
 #include "work_item.hpp"
 
 namespace pmondriaan {
@@ -22,20 +26,35 @@ namespace pmondriaan {
 /**
  * Recursively bisects a hypergraph into k parts with imbalance parameter epsilon.
  * Eta is the load imbalance parameter for the imbalance over the processors during computation.
+ * Returns the cutsize of the partitioning.
  */
-void recursive_bisect(bulk::world& world,
+long recursive_bisect(bulk::world& world,
                       pmondriaan::hypergraph& H,
                       long k,
                       double epsilon,
                       double eta,
                       pmondriaan::options opts) {
+    std::random_device rd;
+    std::mt19937 rng(rd());
+    return recursive_bisect(world, H, k, epsilon, eta, opts, rng, nullptr);
+}
+
+/**
+ * Recursively bisects a hypergraph into k parts, using the cached coarsening
+ * of the first bisection if first_levels is not a nullptr.
+ */
+long recursive_bisect(bulk::world& world,
+                      pmondriaan::hypergraph& H,
+                      long k,
+                      double epsilon,
+                      double eta,
+                      pmondriaan::options opts,
+                      std::mt19937& rng,
+                      pmondriaan::coarsening_levels* first_levels) {
 
     auto s = world.rank();
     auto p = world.active_processors();
 
-    std::random_device rd;
-    std::mt19937 rng(rd());
-
     auto global_weight = pmondriaan::global_weight(world, H);
     long maxweight = ((1.0 + epsilon) * global_weight) / k;
 
@@ -58,6 +77,13 @@ void recursive_bisect(bulk::world& world,
     auto cut_nets = std::vector<pmondriaan::net>();
     long splits = 0; // the number of splits done by this processor
 
+    /* A net that is cut by a bisection of a part gains one part, so the
+       lambda - 1 metric of the partitioning is the sum of the cuts of all
+       bisections. With the cut net metric, the cut nets are removed after a
+       bisection, so the sum counts every cut net once. Each processor sums
+       the bisections it is the first processor of. */
+    long cut = 0;
+
     opts.sample_size = opts.sample_size / p;
 
     // while we need to give more than one label and need to use more than one processor, we bisect the hypergraph in parallel
@@ -72,8 +98,16 @@ void recursive_bisect(bulk::world& world,
         compute_max_global_weight(k_, k_low, k_high, weight_mypart, maxweight);
 
         // part 0 will always have the smallest weight
-        auto weight_parts = bisect(*sub_world, H, opts, max_global_weights[0],
-                                   max_global_weights[1], start, end, labels, rng);
+        auto parent = pmondriaan::hierarchy();
+        auto hierarchy = pmondriaan::hierarchy();
+        long bisection_cut = 0;
+        auto weight_parts =
+        bisect_cached(*sub_world, H, opts, max_global_weights[0], max_global_weights[1],
+                      start, end, labels, rng, parent, hierarchy,
+                      (splits == 1) ? first_levels : nullptr, &bisection_cut);
+        if (sub_world->rank() == 0) {
+            cut += bisection_cut;
+        }
 
         auto total_weight_0 = bulk::sum(*sub_world, weight_parts[0]);
         auto total_weight_1 = bulk::sum(*sub_world, weight_parts[1]);
@@ -146,7 +180,22 @@ void recursive_bisect(bulk::world& world,
         labels = new_labels;
     }
 
-    // we do the rest of the work sequentially
+    // we do the rest of the work sequentially, sharing the jobs if possible
+    if (opts.work_stealing && (world.active_processors() > 1) &&
+        (opts.metric != pmondriaan::m::cut_net)) {
+        auto job_list = std::deque<pmondriaan::work_item>();
+        while (!jobs.empty()) {
+            job_list.push_front(jobs.top());
+            jobs.pop();
+        }
+        cut += bisect_jobs_stealing(world, H, job_list, opts, maxweight, rng);
+    } else if ((opts.threads > 1) && !jobs.empty() &&
+               (opts.metric != pmondriaan::m::cut_net)) {
+        // without a parallel bisection, the first job is the first bisection
+        cut += bisect_jobs_threaded(*sub_world, H, jobs, opts, maxweight, rng,
+                                    (splits == 0) ? first_levels : nullptr);
+    }
+
     while (!jobs.empty()) {
         auto job = jobs.top();
         jobs.pop();
@@ -156,6 +205,12 @@ void recursive_bisect(bulk::world& world,
         labels = {job.label_low(), job.label_high()};
         weight_mypart = job.weight();
 
+        // the coarsening hierarchy of the previous bisection of these vertices
+        auto parent = job.hierarchy();
+        if (!parent) {
+            parent = std::make_shared<pmondriaan::hierarchy>();
+        }
+
         while (labels.length() > 0) {
             splits++;
             long k_ = labels.length() + 1;
@@ -166,8 +221,13 @@ void recursive_bisect(bulk::world& world,
             auto max_global_weights =
             compute_max_global_weight(k_, k_low, k_high, weight_mypart, maxweight);
 
-            auto weight_parts = bisect(*sub_world, H, opts, max_global_weights[0],
-                                       max_global_weights[1], start, end, labels, rng);
+            auto hierarchy = std::make_shared<pmondriaan::hierarchy>();
+            long bisection_cut = 0;
+            auto weight_parts =
+            bisect_cached(*sub_world, H, opts, max_global_weights[0],
+                          max_global_weights[1], start, end, labels, rng, *parent,
+                          *hierarchy, (splits == 1) ? first_levels : nullptr, &bisection_cut);
+            cut += bisection_cut;
 
             interval labels_0 = {labels.low, labels.high - k_high};
             interval labels_1 = {labels.low + k_low, labels.high};
@@ -176,9 +236,10 @@ void recursive_bisect(bulk::world& world,
 
             if (labels_1.length() > 0) {
                 reorder_hypergraph(H, start, end, labels.low, labels.high);
-                jobs.push(pmondriaan::work_item(end, end_1, labels_1.low,
-                                                labels_1.high, weight_parts[1]));
+                jobs.push(pmondriaan::work_item(end, end_1, labels_1.low, labels_1.high,
+                                                weight_parts[1], hierarchy));
             }
+            parent = hierarchy;
             weight_mypart = weight_parts[0];
             labels = labels_0;
 
@@ -196,6 +257,318 @@ void recursive_bisect(bulk::world& world,
     }
 
     world.sync();
+
+    if (opts.kway_refinement) {
+        return kway_refine_par(world, H, k, maxweight, opts);
+    }
+    // only the multilevel bisection knows the cutsize of a bisection
+    if (opts.bisection_mode != pmondriaan::bisection::multilevel) {
+        return pmondriaan::cutsize(world, H, opts.metric);
+    }
+    return bulk::sum(world, cut);
+}
+
+/**
+ * Recursively bisects a copy of the hypergraph H for each job and passes the
+ * partitioned copy and its cutsize to result.
+ */
+void recursive_bisect_batch(bulk::world& world,
+                            const pmondriaan::hypergraph& H,
+                            const std::vector<pmondriaan::batch_job>& jobs,
+                            double eta,
+                            pmondriaan::options opts,
+                            std::function<void(const pmondriaan::batch_job&, pmondriaan::hypergraph&, long)> result) {
+    auto first_levels = pmondriaan::coarsening_levels();
+    for (const auto& job : jobs) {
+        auto H_job = H;
+        std::mt19937 rng(job.seed);
+        auto cut = recursive_bisect(world, H_job, job.k, job.epsilon, eta, opts, rng, &first_levels);
+        result(job, H_job, cut);
+    }
+}
+
+/**
+ * Bisects a hypergraph, using the coarsening stored in first_levels if it is
+ * not a nullptr and storing the coarsening in it if it is empty.
+ */
+std::vector<long> bisect_cached(bulk::world& world,
+                                pmondriaan::hypergraph& H,
+                                pmondriaan::options& opts,
+                                long max_weight_0,
+                                long max_weight_1,
+                                long start,
+                                long end,
+                                interval labels,
+                                std::mt19937& rng,
+                                pmondriaan::hierarchy& parent,
+                                pmondriaan::hierarchy& hierarchy,
+                                pmondriaan::coarsening_levels* first_levels,
+                                long* bisection_cut) {
+    if ((first_levels == nullptr) ||
+        (opts.bisection_mode != pmondriaan::bisection::multilevel)) {
+        return bisect(world, H, opts, max_weight_0, max_weight_1, start, end,
+                      labels, rng, parent, hierarchy, bisection_cut);
+    }
+
+    if (first_levels->HC_list.empty()) {
+        *first_levels = coarsen_multilevel(world, H, opts, start, end, rng, parent);
+    }
+    // the cached levels are changed during uncoarsening, so we work on a copy
+    auto levels = *first_levels;
+    hierarchy = levels.hierarchy;
+    long cut = 0;
+    auto weight_parts = uncoarsen_multilevel(world, H, opts, max_weight_0, max_weight_1,
+                                             labels, rng, levels, &cut);
+    weight_parts = vcycle_multilevel(world, H, opts, max_weight_0, max_weight_1, start, end,
+                                     labels, rng, weight_parts, cut);
+    if (bisection_cut != nullptr) {
+        *bisection_cut = cut;
+    }
+    return weight_parts;
+}
+
+/**
+ * Bisects the sequential jobs of all processors in supersteps of one
+ * bisection each, letting idle processors steal jobs from busy processors.
+ * Returns the sum of the cutsizes of the bisections done by this processor.
+ */
+long bisect_jobs_stealing(bulk::world& world,
+                          pmondriaan::hypergraph& H,
+                          std::deque<pmondriaan::work_item>& jobs,
+                          pmondriaan::options& opts,
+                          long maxweight,
+                          std::mt19937& rng) {
+    auto s = world.rank();
+    auto p = world.active_processors();
+    // every processor bisects its jobs on its own
+    auto seq_world = world.split(s);
+
+    // stolen vertices are stored after the own vertices, together with their owner
+    long own_size = H.size();
+    auto owners = std::vector<int>();
+    auto stolen_nets = std::vector<long>();
+
+    // a stolen job is sent as its owner, labels and weight, followed by its vertices and nets
+    auto job_queue = bulk::queue<int, long, long, long>(world);
+    auto vertex_queue = bulk::queue<long, long, long[]>(world);
+    auto cost_queue = bulk::queue<long, long>(world);
+    auto label_queue = bulk::queue<long, long>(world);
+
+    long cut = 0;
+    while (true) {
+        if (!jobs.empty()) {
+            auto job = jobs.back();
+            jobs.pop_back();
+            long bisection_cut = 0;
+            for (auto& new_job :
+                 bisect_job(*seq_world, H, job, opts, maxweight, rng, &bisection_cut)) {
+                jobs.push_back(new_job);
+            }
+            cut += bisection_cut;
+        }
+
+        /* The remaining work of a job is estimated as its weight times the
+           number of bisection levels left. Only jobs of own vertices are
+           given away, and only if the processor keeps work for itself. */
+        long work = 0;
+        for (auto& job : jobs) {
+            work += job.weight() *
+                    (long)std::ceil(std::log2(job.label_high() - job.label_low() + 1));
+        }
+        long status = -1;
+        if (jobs.empty()) {
+            status = 0;
+        } else if ((jobs.size() > 1) && (jobs.front().start() < own_size)) {
+            status = std::max(work, 1L);
+        }
+        auto all_status = bulk::gather_all(world, status);
+
+        auto idle = std::vector<int>();
+        auto victims = std::vector<int>();
+        for (auto t = 0; t < p; t++) {
+            if (all_status[t] == 0) {
+                idle.push_back(t);
+            } else if (all_status[t] > 0) {
+                victims.push_back(t);
+            }
+        }
+        if (idle.size() == (size_t)p) {
+            break;
+        }
+
+        // the i-th idle processor steals from the processor with the i-th most work
+        std::stable_sort(victims.begin(), victims.end(), [&](int lhs, int rhs) {
+            return all_status[lhs] > all_status[rhs];
+        });
+        for (auto i = 0u; i < std::min(idle.size(), victims.size()); i++) {
+            if (victims[i] != s) {
+                continue;
+            }
+            auto thief = idle[i];
+            auto job = jobs.front();
+            jobs.pop_front();
+
+            auto nets_to_send = std::unordered_set<long>();
+            for (auto index = job.start(); index < job.end(); index++) {
+                auto& v = H(index);
+                nets_to_send.insert(v.nets().begin(), v.nets().end());
+                vertex_queue(thief).send(v.id(), v.weight(), v.nets());
+            }
+            for (auto n : nets_to_send) {
+                cost_queue(thief).send(n, H.net(n).cost());
+            }
+            job_queue(thief).send(s, job.label_low(), job.label_high(), job.weight());
+        }
+        world.sync();
+
+        for (const auto& [net_id, cost] : cost_queue) {
+            if (!H.is_local_net(net_id)) {
+                H.add_net(net_id, std::vector<long>(), cost);
+                stolen_nets.push_back(net_id);
+            }
+        }
+        long start = H.size();
+        for (const auto& [id, weight, nets] : vertex_queue) {
+            H.add_vertex(id, nets, weight);
+            H.add_to_nets(H.vertices().back());
+        }
+        for (const auto& [owner, label_low, label_high, weight] : job_queue) {
+            owners.resize(H.size() - own_size, owner);
+            jobs.push_back(pmondriaan::work_item(start, H.size(), label_low, label_high, weight));
+        }
+    }
+
+    // the labels of the stolen vertices are sent back to their owners
+    for (auto index = own_size; index < (long)H.size(); index++) {
+        label_queue(owners[index - own_size]).send(H(index).id(), H(index).part());
+    }
+    world.sync();
+
+    H.vertices().erase(H.vertices().begin() + own_size, H.vertices().end());
+    H.update_map();
+    for (auto& net : H.nets()) {
+        auto& vertices = net.vertices();
+        vertices.erase(std::remove_if(vertices.begin(), vertices.end(),
+                                      [&](long v) { return !H.is_local(v); }),
+                       vertices.end());
+    }
+    for (auto net_id : stolen_nets) {
+        H.remove_net(net_id);
+    }
+
+    for (const auto& [id, part] : label_queue) {
+        H(H.local_id(id)).set_part(part);
+    }
+    return cut;
+}
+
+/**
+ * Bisects the sequential jobs of this processor, processing jobs on disjoint
+ * vertex ranges concurrently using a pool of threads. The first job uses the
+ * coarsening cached in first_levels if it is not a nullptr. Returns the sum of
+ * the cutsizes of the bisections.
+ */
+long bisect_jobs_threaded(bulk::world& world,
+                          pmondriaan::hypergraph& H,
+                          std::stack<pmondriaan::work_item>& jobs,
+                          pmondriaan::options& opts,
+                          long maxweight,
+                          std::mt19937& rng,
+                          pmondriaan::coarsening_levels* first_levels) {
+    long cut = 0;
+    // the cached coarsening belongs to a single job, so it is bisected before the pool starts
+    if ((first_levels != nullptr) && !jobs.empty()) {
+        auto job = jobs.top();
+        jobs.pop();
+        for (auto& new_job : bisect_job(world, H, job, opts, maxweight, rng, &cut, first_levels)) {
+            jobs.push(new_job);
+        }
+    }
+
+    /* The threads bisect concurrently on their own one-processor worlds. The
+       bisection of a world with one processor must therefore stay free of
+       collectives and other communication, which the MPI backend would only
+       allow with MPI_THREAD_MULTIPLE. */
+    auto pool = pmondriaan::job_pool(opts.threads);
+
+    // every thread gets its own world, random number generator, options and cut
+    auto thread_worlds = std::vector<std::unique_ptr<bulk::world>>();
+    auto thread_rngs = std::vector<std::mt19937>();
+    auto thread_opts = std::vector<pmondriaan::options>(pool.threads(), opts);
+    auto thread_cuts = std::vector<long>(pool.threads(), 0);
+    for (auto t = 0u; t < pool.threads(); t++) {
+        // all threads are already in use by the pool
+        thread_opts[t].threads = 1;
+        thread_worlds.push_back(world.split(0));
+        thread_rngs.push_back(std::mt19937(rng()));
+    }
+
+    while (!jobs.empty()) {
+        pool.push(0, jobs.top());
+        jobs.pop();
+    }
+
+    pool.run([&](size_t t, pmondriaan::work_item job) {
+        long bisection_cut = 0;
+        for (auto& new_job : bisect_job(*thread_worlds[t], H, job, thread_opts[t],
+                                        maxweight, thread_rngs[t], &bisection_cut)) {
+            pool.push(t, new_job);
+        }
+        thread_cuts[t] += bisection_cut;
+    });
+
+    for (auto thread_cut : thread_cuts) {
+        cut += thread_cut;
+    }
+    return cut;
+}
+
+/**
+ * Bisects the vertices of a job once and returns the jobs for the parts that
+ * have to be split further, the last one containing part 0.
+ */
+std::vector<pmondriaan::work_item> bisect_job(bulk::world& world,
+                                              pmondriaan::hypergraph& H,
+                                              pmondriaan::work_item job,
+                                              pmondriaan::options& opts,
+                                              long maxweight,
+                                              std::mt19937& rng,
+                                              long* bisection_cut,
+                                              pmondriaan::coarsening_levels* first_levels) {
+    auto start = job.start();
+    auto end = job.end();
+    interval labels = {job.label_low(), job.label_high()};
+    long k_ = labels.length() + 1;
+    long k_low = k_ / 2;
+    long k_high = k_ - k_low;
+
+    auto max_global_weights =
+    compute_max_global_weight(k_, k_low, k_high, job.weight(), maxweight);
+
+    auto parent = job.hierarchy();
+    if (!parent) {
+        parent = std::make_shared<pmondriaan::hierarchy>();
+    }
+    auto hierarchy = std::make_shared<pmondriaan::hierarchy>();
+    auto weight_parts =
+    bisect_cached(world, H, opts, max_global_weights[0], max_global_weights[1], start, end,
+                  labels, rng, *parent, *hierarchy, first_levels, bisection_cut);
+
+    interval labels_0 = {labels.low, labels.high - k_high};
+    interval labels_1 = {labels.low + k_low, labels.high};
+
+    auto new_jobs = std::vector<pmondriaan::work_item>();
+    long end_1 = end;
+    if (labels_1.length() > 0) {
+        reorder_hypergraph(H, start, end, labels.low, labels.high);
+        new_jobs.push_back(pmondriaan::work_item(end, end_1, labels_1.low, labels_1.high,
+                                                 weight_parts[1], hierarchy));
+    }
+    if (labels_0.length() > 0) {
+        new_jobs.push_back(pmondriaan::work_item(start, end, labels_0.low,
+                                                 labels_0.high, weight_parts[0], hierarchy));
+    }
+    return new_jobs;
 }
 
 std::vector<long>
@@ -357,6 +730,7 @@ long reduce_surplus(bulk::world& world,
  * Reorders the hypergraph such that all vertices with label_high are at the end of the vertex list.
  */
 void reorder_hypergraph(pmondriaan::hypergraph& H, long start, long& end, long label_low, long label_high) {
+    long range_end = end;
     long pivot = start;
     while (pivot < end) {
         if (H(pivot).part() == label_high) {
@@ -368,7 +742,7 @@ void reorder_hypergraph(pmondriaan::hypergraph& H, long start, long& end, long l
         pivot++;
     }
     end--;
-    H.update_map();
+    H.update_map(start, range_end);
 }
 
 /**
@@ -383,9 +757,12 @@ void remove_cut_nets(bulk::world& world,
     if (sub_world.active_processors() == 1) {
         for (auto& net : H.nets()) {
             auto vertices = net.vertices();
-            auto label = H(H.local_id(vertices[0])).id();
+            if (vertices.empty()) {
+                continue;
+            }
+            auto label = H(H.local_id(vertices[0])).part();
             for (auto v : vertices) {
-                if (label != H(H.local_id(v)).id()) {
+                if (label != H(H.local_id(v)).part()) {
                     for (auto t = 0; t < world.active_processors(); t++) {
                         queue(t).send(net.id());
                     }
@@ -401,9 +778,12 @@ void remove_cut_nets(bulk::world& world,
         // this queue contains the label of a net
         auto labels = bulk::queue<long, long>(sub_world);
         for (auto& net : H.nets()) {
+            if (net.vertices().empty()) {
+                continue;
+            }
             auto label_net = H(H.local_id(net.vertices()[0])).part();
             for (auto& v : net.vertices()) {
-                if (label_net != H(H.local_id(v)).id()) {
+                if (label_net != H(H.local_id(v)).part()) {
                     label_net = -1;
                     break;
                 }
@@ -413,7 +793,7 @@ void remove_cut_nets(bulk::world& world,
         sub_world.sync();
 
         auto total_cut =
-        std::vector<int>(net_partition.local_size(world.rank())[0], -2);
+        std::vector<int>(net_partition.local_size(sub_world.rank())[0], -2);
         for (const auto& [net, label_net] : labels) {
             if (total_cut[net_partition.local(net)[0]] == -2) {
                 total_cut[net_partition.local(net)[0]] = label_net;
@@ -0,0 +1,61 @@
+#include <thread>
+#include <vector>
+
+#include "util/job_pool.hpp"
+
+namespace pmondriaan {
+
+void job_pool::push(size_t thread, pmondriaan::work_item job) {
+    pending_++;
+    std::lock_guard<std::mutex> lock(mutexes_[thread]);
+    jobs_[thread].push_back(job);
+}
+
+void job_pool::run(std::function<void(size_t, pmondriaan::work_item)> f) {
+    auto workers = std::vector<std::thread>();
+    for (auto t = 1u; t < threads(); t++) {
+        workers.push_back(std::thread([this, t, &f] { work_(t, f); }));
+    }
+    work_(0, f);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * Returns the newest job of the thread itself, or else the oldest job of another thread.
+ */
+std::optional<pmondriaan::work_item> job_pool::pop_(size_t thread) {
+    {
+        std::lock_guard<std::mutex> lock(mutexes_[thread]);
+        if (!jobs_[thread].empty()) {
+            auto job = jobs_[thread].back();
+            jobs_[thread].pop_back();
+            return job;
+        }
+    }
+    for (auto i = 1u; i < threads(); i++) {
+        auto victim = (thread + i) % threads();
+        std::lock_guard<std::mutex> lock(mutexes_[victim]);
+        if (!jobs_[victim].empty()) {
+            auto job = jobs_[victim].front();
+            jobs_[victim].pop_front();
+            return job;
+        }
+    }
+    return std::nullopt;
+}
+
+void job_pool::work_(size_t thread, std::function<void(size_t, pmondriaan::work_item)>& f) {
+    while (pending_ > 0) {
+        auto job = pop_(thread);
+        if (job) {
+            f(thread, job.value());
+            pending_--;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+} // namespace pmondriaan
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <vector>
+
+#include "util/max_flow.hpp"
+
+namespace pmondriaan {
+
+void max_flow::add_edge(long u, long v, long capacity) {
+    edges_.push_back({v, capacity, first_[u]});
+    first_[u] = edges_.size() - 1;
+    edges_.push_back({u, 0, first_[v]});
+    first_[v] = edges_.size() - 1;
+}
+
+long max_flow::compute(long s, long t) {
+    long flow = 0;
+    while (build_levels_(s, t)) {
+        current_ = first_;
+        flow += augment_(s, t);
+    }
+    return flow;
+}
+
+/**
+ * Computes the distance from s of all nodes in the residual network. Returns
+ * whether t can be reached.
+ */
+bool max_flow::build_levels_(long s, long t) {
+    std::fill(level_.begin(), level_.end(), -1);
+    auto queue = std::queue<long>();
+    level_[s] = 0;
+    queue.push(s);
+    while (!queue.empty()) {
+        auto u = queue.front();
+        queue.pop();
+        for (auto e = first_[u]; e != -1; e = edges_[e].next) {
+            if ((edges_[e].capacity > 0) && (level_[edges_[e].to] == -1)) {
+                level_[edges_[e].to] = level_[u] + 1;
+                queue.push(edges_[e].to);
+            }
+        }
+    }
+    return level_[t] != -1;
+}
+
+/**
+ * Augments along shortest paths until the flow is blocking. The paths are
+ * searched without recursion, as they can be as long as the network is large.
+ */
+long max_flow::augment_(long s, long t) {
+    long flow = 0;
+    auto path = std::vector<long>();
+    auto u = s;
+    while (true) {
+        if (u == t) {
+            auto bottleneck = std::numeric_limits<long>::max();
+            for (auto e : path) {
+                bottleneck = std::min(bottleneck, edges_[e].capacity);
+            }
+            for (auto e : path) {
+                edges_[e].capacity -= bottleneck;
+                edges_[e ^ 1].capacity += bottleneck;
+            }
+            flow += bottleneck;
+            path.clear();
+            u = s;
+            continue;
+        }
+
+        auto& e = current_[u];
+        while ((e != -1) && ((edges_[e].capacity == 0) ||
+                             (level_[edges_[e].to] != level_[u] + 1))) {
+            e = edges_[e].next;
+        }
+        if (e != -1) {
+            path.push_back(e);
+            u = edges_[e].to;
+        } else {
+            // u is a dead end, so it is removed from the level graph
+            level_[u] = -1;
+            if (path.empty()) {
+                return flow;
+            }
+            u = edges_[path.back() ^ 1].to;
+            path.pop_back();
+            current_[u] = edges_[current_[u]].next;
+        }
+    }
+}
+
+std::vector<bool> max_flow::reachable_from(long s) {
+    auto result = std::vector<bool>(nodes(), false);
+    auto queue = std::queue<long>();
+    result[s] = true;
+    queue.push(s);
+    while (!queue.empty()) {
+        auto u = queue.front();
+        queue.pop();
+        for (auto e = first_[u]; e != -1; e = edges_[e].next) {
+            if ((edges_[e].capacity > 0) && !result[edges_[e].to]) {
+                result[edges_[e].to] = true;
+                queue.push(edges_[e].to);
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<bool> max_flow::reaching(long t) {
+    auto result = std::vector<bool>(nodes(), false);
+    auto queue = std::queue<long>();
+    result[t] = true;
+    queue.push(t);
+    while (!queue.empty()) {
+        auto u = queue.front();
+        queue.pop();
+        // the reverse of an edge leaving u is an edge entering u
+        for (auto e = first_[u]; e != -1; e = edges_[e].next) {
+            if ((edges_[e ^ 1].capacity > 0) && !result[edges_[e].to]) {
+                result[edges_[e].to] = true;
+                queue.push(edges_[e].to);
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace pmondriaan
@@ -1,9 +1,13 @@
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <CLI/CLI.hpp>
 
 #ifdef BACKEND_MPI
+#include <mpi.h>
+
 #include <bulk/backends/mpi/mpi.hpp>
 using environment = bulk::mpi::environment;
 #else
@@ -28,6 +32,7 @@ int main(int argc, char** argv) {
         double eta = 0.10;
         std::string matrix_file;
         std::string hypergraph_weights;
+        std::string batch_file;
     };
 
     cli_settings settings;
@@ -49,6 +54,13 @@ int main(int argc, char** argv) {
     app.add_option("--eta", settings.eta,
                    "Maximum imbalance during the parallel computation", settings.eta);
 
+    app
+    .add_option("--batch", settings.batch_file,
+                "File containing a list of jobs 'k eps seed', one per line, that "
+                "are all run on the same hypergraph")
+    ->check(CLI::ExistingFile)
+    ->required(false);
+
     CLI::Option* wopt =
     app.add_option("--weights", settings.hypergraph_weights,
                    "How the weights of the vertices should be computed");
@@ -69,6 +81,27 @@ int main(int argc, char** argv) {
     .add_option("--sampling", options.sampling_mode, "Sampling mode to be used")
     ->transform(CLI::CheckedTransformer(sampling_map, CLI::ignore_case));
 
+    std::map<std::string, pmondriaan::initial> initial_map{
+    {"label_propagation", pmondriaan::initial::label_propagation},
+    {"ghg", pmondriaan::initial::ghg},
+    {"random", pmondriaan::initial::random},
+    {"bfs", pmondriaan::initial::bfs},
+    {"portfolio", pmondriaan::initial::portfolio}};
+
+    app
+    .add_option("--initial", options.initial_mode, "Initial partitioning method to be used")
+    ->transform(CLI::CheckedTransformer(initial_map, CLI::ignore_case));
+
+    std::map<std::string, pmondriaan::refinement> refinement_map{
+    {"klfm", pmondriaan::refinement::klfm},
+    {"label_propagation", pmondriaan::refinement::label_propagation},
+    {"jet", pmondriaan::refinement::jet}};
+
+    app
+    .add_option("--refinement", options.refinement_par,
+                "Refinement method used in the parallel uncoarsening")
+    ->transform(CLI::CheckedTransformer(refinement_map, CLI::ignore_case));
+
     std::map<std::string, pmondriaan::m> metric_map{{"cutnet", pmondriaan::m::cut_net},
                                                     {"lambda_minus_one",
                                                      pmondriaan::m::lambda_minus_one}};
@@ -87,6 +120,55 @@ int main(int argc, char** argv) {
                    "stops");
     app.add_option("--coarsening_max_rounds", options.coarsening_maxrounds,
                    "The maximum number of coarsening rounds");
+    app.add_option("--coarsening_reuse", options.coarsening_reuse,
+                   "Reuse the coarsening hierarchy of a bisection in the "
+                   "sequential bisections of its parts");
+    app.add_option("--work_stealing", options.work_stealing,
+                   "Let idle processors steal sequential bisection jobs from "
+                   "busy processors");
+    app.add_option("--threads", options.threads,
+                   "The number of threads per processor used for the "
+                   "sequential bisections and the initial partitioning");
+    app.add_option("--initial_attempts", options.initial_attempts,
+                   "The number of initial partitioning attempts, divided over "
+                   "the processors of a bisection");
+    app.add_option("--initial_max_no_improvement", options.initial_max_no_improvement,
+                   "The number of initial partitioning attempts without "
+                   "improvement after which a processor stops, 0 never stops early");
+    app.add_option("--refinement_min_size", options.refinement_min_size,
+                   "The minimum number of vertices of a level refined by the "
+                   "selected parallel refinement, smaller levels use parallel KLFM");
+    app.add_option("--jet_negative_gain_factor", options.jet_negative_gain_factor,
+                   "The factor of the connectivity of a vertex to its own part "
+                   "that its loss may be to be a candidate in the jet refinement");
+    app.add_option("--jet_max_no_improvement", options.jet_max_no_improvement,
+                   "The number of iterations without improvement after which "
+                   "the jet refinement stops");
+    app.add_option("--balance_net_ownership", options.balance_net_ownership,
+                   "Divide the nets over the processors by their number of "
+                   "pins instead of their number");
+    app.add_option("--kway_refinement", options.kway_refinement,
+                   "Refine the final k-way partitioning by moving vertices "
+                   "between any two parts");
+    app.add_option("--kway_max_rounds", options.kway_max_rounds,
+                   "The maximum number of rounds of the k-way refinement");
+    app.add_option("--flow_refinement", options.flow_refinement,
+                   "Refine the levels of the sequential uncoarsening by minimum "
+                   "cuts before KLFM");
+    app.add_option("--flow_region_factor", options.flow_region_factor,
+                   "Scales the size of the region around the cut used by the "
+                   "flow refinement");
+    app.add_option("--vcycles", options.vcycles,
+                   "The maximum number of V-cycles that refine every multilevel "
+                   "bisection");
+    app.add_option("--vcycle_time_limit", options.vcycle_time_limit,
+                   "The time in milliseconds after which no new V-cycle is "
+                   "started, 0 for no limit");
+    app.add_option("--KLFM_adaptive_stopping", options.KLFM_adaptive_stopping,
+                   "Stop KLFM passes by a random walk model of the gains instead of "
+                   "after a fixed number of no-gain moves");
+    app.add_option("--KLFM_stopping_alpha", options.KLFM_stopping_alpha,
+                   "The factor of the variance of the gains in the adaptive stopping rule");
     app.add_option("--KLFM_max_passes", options.KLFM_max_passes,
                    "The maximum number of passes during the KLFM algorithm");
     app.add_option("--KLFM_max_no_gain_moves", options.KLFM_max_no_gain_moves,
@@ -98,11 +180,38 @@ int main(int argc, char** argv) {
 
     CLI11_PARSE(app, argc, argv);
 
+    auto batch_jobs = std::vector<pmondriaan::batch_job>();
+    if (!settings.batch_file.empty()) {
+        std::ifstream fin(settings.batch_file);
+        pmondriaan::batch_job job;
+        while (fin >> job.k >> job.epsilon >> job.seed) {
+            batch_jobs.push_back(job);
+        }
+        if (batch_jobs.empty()) {
+            std::cerr << "Error: no jobs found in batch file\n";
+            return 1;
+        }
+    }
+
     environment env;
     /* Start parallel part */
-    env.spawn(settings.p, [&settings, &options, &app](bulk::world& world) {
+    env.spawn(settings.p, [&settings, &options, &app, &batch_jobs](bulk::world& world) {
         auto s = world.rank();
 
+#ifdef BACKEND_MPI
+        // the threads of a processor use bulk concurrently, which MPI only
+        // allows if it provides MPI_THREAD_MULTIPLE
+        int provided = MPI_THREAD_SINGLE;
+        MPI_Query_thread(&provided);
+        if ((options.threads > 1) && (provided < MPI_THREAD_MULTIPLE)) {
+            if (s == 0) {
+                std::cerr << "Warning: MPI does not provide MPI_THREAD_MULTIPLE, "
+                             "using 1 thread per processor\n";
+            }
+            options.threads = 1;
+        }
+#endif
+
         if (s == 0) {
             // write the settings to the defaults file
             auto conf = app.config_to_str();
@@ -119,18 +228,47 @@ int main(int argc, char** argv) {
             return;
         }
         auto H = hypergraph.value();
+        auto matrix_name =
+        settings.matrix_file.substr(settings.matrix_file.find_last_of('/') + 1);
+
+        // in batch mode, the hypergraph is only loaded once and the first coarsening is shared
+        if (!batch_jobs.empty()) {
+            auto time = bulk::util::timer();
+            pmondriaan::recursive_bisect_batch(
+            world, H, batch_jobs, settings.eta, options,
+            [&](const pmondriaan::batch_job& job, pmondriaan::hypergraph& H_job, long cutsize) {
+                auto time_used = time.get_change();
+                auto lb = pmondriaan::load_balance(world, H_job, job.k);
+                if (!partitioning_to_file(world, H_job,
+                                          "../tools/results/" + matrix_name + "-k" +
+                                          std::to_string(job.k) + "-p" +
+                                          std::to_string(settings.p) + "-eps" +
+                                          std::to_string(job.epsilon) + "-s" +
+                                          std::to_string(job.seed),
+                                          job.k)) {
+                    std::cerr << "Error: failed to write partitioning to file\n";
+                }
+                if (s == 0) {
+                    world.log("Job k=%d eps=%lf seed=%u: load balance %lf, "
+                              "cutsize %d, time used %lf milliseconds",
+                              job.k, job.epsilon, job.seed, lb, cutsize, time_used);
+                }
+                time.get_change();
+            });
+
+            world.sync();
+            return;
+        }
 
         auto time = bulk::util::timer();
+        auto cutsize =
         recursive_bisect(world, H, settings.k, settings.eps, settings.eta, options);
         auto time_used = time.get();
 
         auto lb = pmondriaan::load_balance(world, H, settings.k);
-        auto cutsize = pmondriaan::cutsize(world, H, options.metric);
         if (!partitioning_to_file(world, H,
-                                  "../tools/results/" +
-                                  settings.matrix_file.substr(
-                                  settings.matrix_file.find_last_of('/') + 1) +
-                                  "-k" + std::to_string(settings.k) + "-p" +
+                                  "../tools/results/" + matrix_name + "-k" +
+                                  std::to_string(settings.k) + "-p" +
                                   std::to_string(settings.p),
                                   settings.k)) {
             std::cerr << "Error: failed to write partitioning to file\n";
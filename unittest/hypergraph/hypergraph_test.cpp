@@ -22,6 +22,15 @@ std::string mtx_three_nonzeros = R"(%%MatrixMarket matrix coordinate real genera
 1 3 1.0
 )";
 
+std::string mtx_three_parts = R"(%%MatrixMarket matrix coordinate real general
+3 3 5
+1 1 1.0
+1 2 1.0
+1 3 1.0
+2 1 1.0
+2 2 1.0
+)";
+
 TEST(Cutsize, CutsizeCutnet) {
     environment env;
     env.spawn(2, [](bulk::world& world) {
@@ -40,6 +49,23 @@ TEST(Cutsize, CutsizeCutnet) {
     });
 }
 
+TEST(Cutsize, CutsizeLambdaMinusOne) {
+    environment env;
+    env.spawn(2, [](bulk::world& world) {
+        std::stringstream mtx_ss(mtx_three_parts);
+        auto hypergraph = read_hypergraph_istream(mtx_ss, world, "degree");
+        auto H = hypergraph.value();
+        for (auto& v : H.vertices()) {
+            v.set_part(v.id());
+        }
+        // the first net is in three parts, the second in two
+        ASSERT_EQ(pmondriaan::cutsize(world, H, pmondriaan::m::lambda_minus_one), 3);
+        ASSERT_EQ(pmondriaan::cutsize(world, H, pmondriaan::m::cut_net), 2);
+        auto directory = pmondriaan::net_directory(world, H);
+        ASSERT_EQ(pmondriaan::cutsize(world, H, pmondriaan::m::lambda_minus_one, directory), 3);
+    });
+}
+
 } // namespace
 } // namespace pmondriaan
 
@@ -0,0 +1,105 @@
+#include "pmondriaan.hpp"
+
+#include <cstdint>
+
+#include "gtest/gtest.h"
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+using environment = bulk::mpi::environment;
+#else
+#include <bulk/backends/thread/thread.hpp>
+using environment = bulk::thread::environment;
+#endif
+
+namespace pmondriaan {
+namespace {
+
+std::string test_mtx = R"(%%MatrixMarket matrix coordinate real general
+7 6 16
+1 1 1.0
+1 2 1.0
+1 3 1.0
+2 1 1.0
+2 4 1.0
+3 2 1.0
+3 5 1.0
+4 3 1.0
+4 6 1.0
+5 4 1.0
+5 5 1.0
+6 6 1.0
+6 1 1.0
+7 2 1.0
+7 4 1.0
+7 6 1.0
+)";
+
+TEST(Replicate, ReplicateHypergraph) {
+    environment env;
+    env.spawn(3, [](bulk::world& world) {
+        std::stringstream mtx_ss(test_mtx);
+        auto hypergraph = read_hypergraph_istream(mtx_ss, world, "degree");
+        auto H = hypergraph.value();
+        for (auto& n : H.nets()) {
+            n.set_cost(n.id() + 1);
+        }
+        auto sizes = global_net_sizes(world, H);
+
+        auto H_rep = replicate_hypergraph(world, H);
+        ASSERT_EQ(H_rep.size(), H.global_size());
+        ASSERT_EQ(H_rep.global_size(), H.global_size());
+        ASSERT_EQ(H_rep.total_weight(), global_weight(world, H));
+        H_rep.check_maps();
+
+        // the local vertices come first in the same order
+        for (auto i = 0u; i < H.size(); i++) {
+            ASSERT_EQ(H_rep(i).id(), H(i).id());
+            ASSERT_EQ(H_rep(i).nets(), H(i).nets());
+        }
+
+        // every net contains all its pins and is sent with its cost
+        for (auto i = 0u; i < H.nets().size(); i++) {
+            auto& n = H_rep.net(H.nets()[i].id());
+            ASSERT_EQ(n.size(), sizes[i]);
+            ASSERT_EQ(n.global_size(), sizes[i]);
+        }
+        auto nr_pins = 0u;
+        for (auto& n : H_rep.nets()) {
+            ASSERT_EQ(n.cost(), n.id() + 1);
+            nr_pins += n.size();
+        }
+        ASSERT_EQ(H_rep.nets().size(), H.global_number_nets());
+        ASSERT_EQ(nr_pins, 16u);
+        ASSERT_EQ(H_rep.nr_nz(), 16u);
+    });
+}
+
+#ifndef BACKEND_MPI
+TEST(Replicate, ReplicateHypergraphShared) {
+    environment env;
+    env.spawn(3, [](bulk::world& world) {
+        std::stringstream mtx_ss(test_mtx);
+        auto hypergraph = read_hypergraph_istream(mtx_ss, world, "degree");
+        auto H = hypergraph.value();
+
+        auto H_shared = replicate_hypergraph_shared(world, H);
+        ASSERT_EQ(H_shared->size(), H.global_size());
+        ASSERT_EQ(H_shared->total_weight(), global_weight(world, H));
+
+        // all threads hold the same hypergraph
+        auto addresses = bulk::gather_all(world, reinterpret_cast<std::uintptr_t>(H_shared.get()));
+        for (auto t = 0; t < world.active_processors(); t++) {
+            ASSERT_EQ(addresses[t], addresses[0]);
+        }
+        for (auto& v : H.vertices()) {
+            ASSERT_TRUE(H_shared->is_local(v.id()));
+        }
+        world.sync();
+    });
+}
+#endif
+
+} // namespace
+} // namespace pmondriaan
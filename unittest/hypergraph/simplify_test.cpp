@@ -63,5 +63,31 @@ TEST(Simplify, SimplifyDuplicateNets) {
     }
 }
 
+TEST(Simplify, ParallelSimplifyDuplicateNets) {
+    environment env;
+    env.spawn(2, [](bulk::world& world) {
+        std::stringstream mtx_ss(test_mtx);
+        auto hypergraph = read_hypergraph_istream(mtx_ss, world, "one");
+        auto H = hypergraph.value();
+        auto old_number_nets = H.nets().size();
+        simplify_duplicate_nets(world, H);
+        for (auto net : H.nets()) {
+            ASSERT_NE(net.id(), 1);
+            ASSERT_NE(net.id(), 4);
+            if (net.id() == 2) {
+                ASSERT_EQ(net.cost(), 1);
+            } else {
+                ASSERT_EQ(net.cost(), 2);
+            }
+        }
+
+        H.reset_duplicate_nets();
+        ASSERT_EQ(H.nets().size(), old_number_nets);
+        for (auto net : H.nets()) {
+            ASSERT_EQ(net.cost(), 1);
+        }
+    });
+}
+
 } // namespace
 } // namespace pmondriaan
@@ -0,0 +1,86 @@
+#include <algorithm>
+
+#include "pmondriaan.hpp"
+
+#include "gtest/gtest.h"
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+using environment = bulk::mpi::environment;
+#else
+#include <bulk/backends/thread/thread.hpp>
+using environment = bulk::thread::environment;
+#endif
+
+namespace pmondriaan {
+namespace {
+
+TEST(KwayRefinement, AddCount) {
+    auto counts = std::vector<std::pair<long, long>>();
+    add_count(counts, 5, 2);
+    add_count(counts, 1, 1);
+    add_count(counts, 3, 1);
+    ASSERT_EQ(counts, (std::vector<std::pair<long, long>>{{1, 1}, {3, 1}, {5, 2}}));
+    add_count(counts, 5, -1);
+    add_count(counts, 3, -1);
+    ASSERT_EQ(counts, (std::vector<std::pair<long, long>>{{1, 1}, {5, 1}}));
+    ASSERT_EQ(kway_counts::count(counts, 5), 1);
+    ASSERT_EQ(kway_counts::count(counts, 3), 0);
+}
+
+TEST(KwayRefinement, KwayRefinePar) {
+    for (auto metric : {pmondriaan::m::lambda_minus_one, pmondriaan::m::cut_net}) {
+        environment env;
+        env.spawn(3, [metric](bulk::world& world) {
+            auto H = pmondriaan::read_hypergraph(
+                     "../test/data/matrices/dolphins/dolphins.mtx", world, "degree")
+                     .value();
+            long k = 4;
+            for (auto& v : H.vertices()) {
+                v.set_part(v.id() % k);
+            }
+            pmondriaan::options opts;
+            opts.metric = metric;
+            opts.kway_max_rounds = 16;
+            auto weights = pmondriaan::global_weight_parts(world, H, k);
+            auto max_weight = *std::max_element(weights.begin(), weights.end()) + 10;
+            auto cut_before = pmondriaan::cutsize(world, H, opts.metric);
+
+            auto cut = kway_refine_par(world, H, k, max_weight, opts);
+            ASSERT_EQ(cut, pmondriaan::cutsize(world, H, opts.metric));
+            ASSERT_LT(cut, cut_before);
+            for (auto weight : pmondriaan::global_weight_parts(world, H, k)) {
+                ASSERT_LE(weight, max_weight);
+            }
+        });
+    }
+}
+
+TEST(KwayRefinement, RecursiveBisectKway) {
+    environment env;
+    env.spawn(3, [](bulk::world& world) {
+        auto H = pmondriaan::read_hypergraph(
+                 "../test/data/matrices/dolphins/dolphins.mtx", world, "degree")
+                 .value();
+        pmondriaan::options opts;
+        opts.sample_size = 30;
+        opts.KLFM_max_passes = 10;
+        opts.KLFM_max_no_gain_moves = 100;
+        opts.metric = pmondriaan::m::lambda_minus_one;
+        opts.sampling_mode = pmondriaan::sampling::random;
+        opts.bisection_mode = pmondriaan::bisection::multilevel;
+        opts.coarsening_max_clustersize = 5;
+        opts.lp_max_iterations = 10;
+        opts.coarsening_nrvertices = 10;
+        opts.coarsening_maxrounds = 10;
+        opts.KLFM_par_number_send_moves = 4;
+        opts.kway_refinement = true;
+        auto cut = recursive_bisect(world, H, 6, 0.1, 0.1, opts);
+        ASSERT_EQ(cut, pmondriaan::cutsize(world, H, opts.metric));
+        ASSERT_LE(pmondriaan::load_balance(world, H, 6), 0.1);
+    });
+}
+
+} // namespace
+} // namespace pmondriaan
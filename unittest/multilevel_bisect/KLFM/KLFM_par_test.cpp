@@ -76,14 +76,9 @@ TEST(KLFMParallel, InitPreviousC) {
             ASSERT_EQ(C[1][0], 1);
             ASSERT_EQ(C[1][1], 1);
         }
-        auto net_partition = bulk::block_partitioning<1>({H.global_number_nets()}, 2);
-        auto previous_C = bulk::coarray<long>(world, net_partition.local_count(s) * 2);
-        auto cost_my_nets = bulk::coarray<long>(world, net_partition.local_count(s));
-        auto procs_my_nets =
-        std::vector<std::vector<int>>(net_partition.local_count(s));
-        init_cost_my_nets(world, H, cost_my_nets, procs_my_nets);
-        auto cut_size_my_nets =
-        init_previous_C(world, H, C, previous_C, net_partition, cost_my_nets);
+        auto directory = pmondriaan::net_directory(world, H);
+        auto previous_C = std::vector<long>(directory.local_count() * 2, 0);
+        auto cut_size_my_nets = init_previous_C(world, H, C, previous_C, directory);
         if (s == 0) {
             ASSERT_EQ(cut_size_my_nets, 2);
         }
@@ -93,25 +88,52 @@ TEST(KLFMParallel, InitPreviousC) {
     });
 }
 
-TEST(KLFMParallel, InitCostNets) {
+TEST(KLFMParallel, NetDirectory) {
     environment env;
     env.spawn(2, [](bulk::world& world) {
         auto s = world.rank();
         std::stringstream mtx_ss(mtx_three_nonzeros);
         auto hypergraph = read_hypergraph_istream(mtx_ss, world, "degree");
         auto H = hypergraph.value();
-        auto net_partition = bulk::block_partitioning<1>({H.global_number_nets()}, 2);
-        auto cost_my_nets = bulk::coarray<long>(world, net_partition.local_count(s));
-        auto procs_my_nets =
-        std::vector<std::vector<int>>(net_partition.local_count(s));
-        init_cost_my_nets(world, H, cost_my_nets, procs_my_nets);
+        auto directory = pmondriaan::net_directory(world, H);
 
+        ASSERT_EQ(directory.owner(1), 0);
+        ASSERT_EQ(directory.owner(2), 1);
         if (s == 0) {
-            ASSERT_EQ(cost_my_nets[0], 1);
-            ASSERT_EQ(cost_my_nets[1], 1);
-            ASSERT_EQ(procs_my_nets[0].size(), 2);
-            ASSERT_EQ(procs_my_nets[1].size(), 1);
-            ASSERT_EQ(procs_my_nets[1][0], 0);
+            ASSERT_EQ(directory.local_count(), 2);
+            ASSERT_EQ(directory.cost(0), 1);
+            ASSERT_EQ(directory.cost(1), 1);
+            ASSERT_EQ(directory.procs(0).size(), 2);
+            ASSERT_EQ(directory.procs(1).size(), 1);
+            ASSERT_EQ(directory.procs(1)[0], 0);
+            ASSERT_EQ(directory.global_size(0), 2);
+        }
+    });
+}
+
+TEST(KLFMParallel, NetDirectoryBalanced) {
+    environment env;
+    env.spawn(2, [](bulk::world& world) {
+        auto s = world.rank();
+        std::stringstream mtx_ss(mtx_three_nonzeros);
+        auto hypergraph = read_hypergraph_istream(mtx_ss, world, "degree");
+        auto H = hypergraph.value();
+        auto directory = pmondriaan::net_directory(world, H, true);
+
+        // nets 0 and 1 have two pins each and net 2 is empty
+        ASSERT_EQ(directory.owner(0), 0);
+        ASSERT_EQ(directory.owner(1), 1);
+        ASSERT_EQ(directory.owner(2), 1);
+        if (s == 0) {
+            ASSERT_EQ(directory.local_count(), 1);
+            ASSERT_EQ(directory.global_size(0), 2);
+        }
+        if (s == 1) {
+            ASSERT_EQ(directory.local_count(), 2);
+            ASSERT_EQ(directory.global(0), 1);
+            ASSERT_EQ(directory.local(2), 1);
+            ASSERT_EQ(directory.global_size(0), 2);
+            ASSERT_EQ(directory.global_size(1), 0);
         }
     });
 }
@@ -120,27 +142,30 @@ TEST(KLFMParallel, RejectMoves) {
     environment env;
     env.spawn(2, [](bulk::world& world) {
         auto s = world.rank();
-        // Stores the proposed moves as: gain, weight change, processor id
-        auto moves_queue = bulk::queue<long, long, int, long>(world);
+        // Stores the proposed moves as: vertex, gain, weight change
+        auto moves = std::vector<std::tuple<long, long, long>>();
         if (s == 0) {
-            moves_queue(0).send(5, -3, s, 0);
-            moves_queue(0).send(3, -4, s, 1);
-            moves_queue(0).send(1, 3, s, 2);
-            moves_queue(0).send(-2, -1, s, 3);
-            moves_queue(0).send(-2, 2, s, 4);
+            moves = {{0, 5, -3}, {1, 3, -4}, {2, 1, 3}, {3, -2, -1}, {4, -2, 2}};
         } else {
-            moves_queue(0).send(5, -1, s, 0);
-            moves_queue(0).send(4, -2, s, 1);
-            moves_queue(0).send(2, -3, s, 2);
-            moves_queue(0).send(1, 4, s, 3);
-            moves_queue(0).send(-5, 0, s, 4);
+            moves = {{0, 5, -1}, {1, 4, -2}, {2, 2, -3}, {3, 1, 4}, {4, -5, 0}, {-1, 0, 0}};
+        }
+        auto summary = summarize_moves(moves);
+        if (s == 0) {
+            ASSERT_EQ(summary[0], std::vector<long>({-2, 2, 1, 5}));
+            ASSERT_EQ(summary[1], std::vector<long>({-2, 1, 3, 5, 5, 8}));
+        }
+        auto summaries = bulk::queue<int, long[], long[]>(world);
+        for (auto t = 0; t < world.active_processors(); t++) {
+            summaries(t).send(s, summary[0], summary[1]);
         }
         world.sync();
         auto prev_total_weights = std::array<long, 2>({20, 18});
         long max_weight_0 = 22;
         long max_weight_1 = 22;
-        auto rejected = reject_unbalanced_moves(world, moves_queue, prev_total_weights,
+        auto rejected = reject_unbalanced_moves(world, summaries, prev_total_weights,
                                                 max_weight_0, max_weight_1);
+        ASSERT_EQ(prev_total_weights[0], 16);
+        ASSERT_EQ(prev_total_weights[1], 22);
         if (s == 0) {
             ASSERT_EQ(rejected, -1);
         }
@@ -150,6 +175,37 @@ TEST(KLFMParallel, RejectMoves) {
     });
 }
 
+TEST(KLFMParallel, RejectMovesInOrder) {
+    environment env;
+    env.spawn(2, [](bulk::world& world) {
+        auto s = world.rank();
+        // the moves into part 0 of processor 1 are undone from the last one, so
+        // its second move can only be undone after its third move
+        auto moves = std::vector<std::tuple<long, long, long>>();
+        if (s == 0) {
+            moves = {{0, 3, 2}};
+        } else {
+            moves = {{0, 6, 1}, {1, 1, 2}, {2, 4, 3}};
+        }
+        auto summary = summarize_moves(moves);
+        auto summaries = bulk::queue<int, long[], long[]>(world);
+        for (auto t = 0; t < world.active_processors(); t++) {
+            summaries(t).send(s, summary[0], summary[1]);
+        }
+        world.sync();
+        auto total_weights = std::array<long, 2>({20, 20});
+        auto rejected = reject_unbalanced_moves(world, summaries, total_weights, 24, 24);
+        ASSERT_EQ(total_weights[0], 23);
+        ASSERT_EQ(total_weights[1], 17);
+        if (s == 0) {
+            ASSERT_EQ(rejected, 1);
+        }
+        if (s == 1) {
+            ASSERT_EQ(rejected, 1);
+        }
+    });
+}
+
 TEST(KLFMParallel, KLFMPar) {
     environment env;
     env.spawn(2, [](bulk::world& world) {
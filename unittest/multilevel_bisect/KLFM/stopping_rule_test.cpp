@@ -0,0 +1,67 @@
+#include "pmondriaan.hpp"
+
+#include <random>
+
+#include "gtest/gtest.h"
+
+namespace pmondriaan {
+namespace {
+
+TEST(StoppingRule, ConstantLoss) {
+    // beta = ln(100) is about 4.6, so constant losses stop after 5 steps
+    auto stopping = pmondriaan::stopping_rule(1.0, 100);
+    for (auto i = 0; i < 4; i++) {
+        stopping.add(-1, false);
+        ASSERT_FALSE(stopping.stop());
+    }
+    stopping.add(-1, false);
+    ASSERT_TRUE(stopping.stop());
+
+    // an improvement restarts the statistics
+    stopping.add(5, true);
+    ASSERT_FALSE(stopping.stop());
+    stopping.add(-1, false);
+    ASSERT_FALSE(stopping.stop());
+}
+
+TEST(StoppingRule, VariableGains) {
+    // with a large variance the walk can still reach a better solution
+    auto stopping = pmondriaan::stopping_rule(1.0, 100);
+    for (auto i = 0; i < 20; i++) {
+        stopping.add((i % 2 == 0) ? -12 : 10, false);
+        ASSERT_FALSE(stopping.stop());
+    }
+    auto strict = pmondriaan::stopping_rule(0.0, 100);
+    for (auto i = 0; i < 10; i++) {
+        strict.add((i % 2 == 0) ? -12 : 10, false);
+    }
+    ASSERT_TRUE(strict.stop());
+}
+
+TEST(StoppingRule, KLFMStatistics) {
+    auto H = pmondriaan::read_hypergraph("../test/data/matrices/dolphins/dolphins.mtx", "degree")
+             .value();
+    std::mt19937 rng(1);
+    for (auto i = 0u; i < H.size(); i++) {
+        H(i).set_part(i % 2);
+    }
+    auto C = pmondriaan::init_counts(H);
+    auto start_cut = pmondriaan::cutsize(H, C);
+    pmondriaan::options opts;
+    opts.KLFM_max_passes = 10;
+    opts.metric = pmondriaan::m::lambda_minus_one;
+    opts.KLFM_adaptive_stopping = true;
+    auto weights = H.weight_all_parts(2);
+    auto stats = pmondriaan::KLFM_statistics();
+    auto cut = KLFM(H, C, weights[0], weights[1], 170, 170, opts, rng,
+                    std::numeric_limits<long>::max(), &stats);
+    ASSERT_LT(cut, start_cut);
+    ASSERT_EQ(cut, pmondriaan::cutsize(H, opts.metric));
+    ASSERT_LE(H.weight_part(0), 170);
+    ASSERT_LE(H.weight_part(1), 170);
+    ASSERT_GT(stats.moves, 0);
+    ASSERT_LE(stats.rolled_back, stats.moves);
+}
+
+} // namespace
+} // namespace pmondriaan
@@ -71,5 +71,72 @@ TEST(BisectMultilevel, ParBisectMultilevel) {
     });
 }
 
+TEST(BisectMultilevel, SeqVcycles) {
+    environment env;
+    env.spawn(1, [](bulk::world& world) {
+        pmondriaan::options opts;
+        opts.KLFM_max_passes = 10;
+        opts.metric = pmondriaan::m::lambda_minus_one;
+        opts.coarsening_max_clustersize = 5;
+        opts.lp_max_iterations = 10;
+        opts.coarsening_nrvertices = 20;
+        opts.coarsening_maxrounds = 4;
+        pmondriaan::interval labels = {0, 3};
+
+        // the cycles start from the same bisection, so they can only lower the cutsize
+        auto cuts = std::vector<long>();
+        for (auto vcycles : {0, 3}) {
+            auto H = pmondriaan::read_hypergraph(
+                     "../test/data/matrices/dolphins/dolphins.mtx", "degree")
+                     .value();
+            std::mt19937 rng(1);
+            opts.vcycles = vcycles;
+            auto parent = pmondriaan::hierarchy();
+            auto hierarchy = pmondriaan::hierarchy();
+            long cut = 0;
+            auto weights = bisect_multilevel(world, H, opts, 163, 163, 0, H.size(), labels,
+                                             rng, parent, hierarchy, &cut);
+            ASSERT_EQ(weights[0], H.weight_part(0));
+            ASSERT_EQ(weights[1], H.weight_part(3));
+            ASSERT_LE(H.weight_part(0), 163);
+            ASSERT_LE(H.weight_part(3), 163);
+            ASSERT_EQ(cut, pmondriaan::cutsize(H, opts.metric));
+            cuts.push_back(cut);
+        }
+        ASSERT_LE(cuts[1], cuts[0]);
+    });
+}
+
+TEST(BisectMultilevel, ParVcycles) {
+    environment env;
+    env.spawn(3, [](bulk::world& world) {
+        auto H = pmondriaan::read_hypergraph(
+                 "../test/data/matrices/dolphins/dolphins.mtx", world, "degree")
+                 .value();
+        std::mt19937 rng(world.rank() + 1);
+        pmondriaan::options opts;
+        opts.sample_size = 4;
+        opts.KLFM_max_passes = 10;
+        opts.metric = pmondriaan::m::lambda_minus_one;
+        opts.sampling_mode = pmondriaan::sampling::label_propagation;
+        opts.coarsening_max_clustersize = 5;
+        opts.lp_max_iterations = 10;
+        opts.coarsening_nrvertices = 20;
+        opts.coarsening_maxrounds = 4;
+        opts.KLFM_par_number_send_moves = 4;
+        opts.vcycles = 3;
+        pmondriaan::interval labels = {0, 3};
+        auto parent = pmondriaan::hierarchy();
+        auto hierarchy = pmondriaan::hierarchy();
+        long cut = 0;
+        bisect_multilevel(world, H, opts, 163, 163, 0, H.size(), labels, rng, parent,
+                          hierarchy, &cut);
+        ASSERT_LE(global_weight_part(world, H, 0), 163);
+        ASSERT_LE(global_weight_part(world, H, 3), 163);
+        ASSERT_EQ(global_weight_part(world, H, 1), 0);
+        ASSERT_EQ(cut, pmondriaan::cutsize(world, H, opts.metric));
+    });
+}
+
 } // namespace
 } // namespace pmondriaan
@@ -0,0 +1,94 @@
+#include "pmondriaan.hpp"
+
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+using environment = bulk::mpi::environment;
+#else
+#include <bulk/backends/thread/thread.hpp>
+using environment = bulk::thread::environment;
+#endif
+
+namespace pmondriaan {
+namespace {
+
+std::string test_mtx = R"(%%MatrixMarket matrix coordinate real general
+4 5 10
+1 1 1.0
+1 2 1.0
+1 3 1.0
+2 1 1.0
+2 2 1.0
+2 4 1.0
+3 3 1.0
+3 4 1.0
+3 5 1.0
+4 4 1.0
+)";
+
+TEST(Coarsen, ContractIdenticalVertices) {
+    environment env;
+    env.spawn(2, [](bulk::world& world) {
+        std::stringstream mtx_ss(test_mtx);
+        auto hypergraph = read_hypergraph_istream(mtx_ss, world, "one");
+        auto H = hypergraph.value();
+        pmondriaan::options opts;
+        opts.coarsening_max_clustersize = 5;
+        auto C = pmondriaan::contraction();
+        auto HC = contract_identical_vertices(world, H, C, opts);
+        ASSERT_TRUE(C.identical());
+        ASSERT_EQ(HC.global_size(), 4);
+        ASSERT_EQ(global_weight(world, HC), 5);
+
+        for (auto& v : HC.vertices()) {
+            v.set_part(v.id() % 2);
+        }
+        std::mt19937 rng(1);
+        C.assign_free_vertices(world, HC, 5, 5, rng);
+        uncoarsen_hypergraph(world, HC, H, C);
+        auto parts = bulk::coarray<long>(world, 5);
+        for (auto& v : H.vertices()) {
+            ASSERT_NE(v.part(), -1);
+            for (auto t = 0; t < world.active_processors(); t++) {
+                parts(t)[v.id()] = v.part();
+            }
+        }
+        world.sync();
+        ASSERT_EQ(parts[0], parts[1]);
+    });
+}
+
+TEST(Coarsen, CoarsenProjected) {
+    environment env;
+    env.spawn(1, [](bulk::world& world) {
+        std::stringstream mtx_ss(test_mtx);
+        auto H = read_hypergraph_istream(mtx_ss, "one").value();
+
+        // the parent clustered vertices 0 and 1 and vertices 2, 3 and 4
+        auto C_parent = pmondriaan::contraction();
+        C_parent.add_sample(0);
+        C_parent.add_match(0, 1, 0);
+        C_parent.add_sample(2);
+        C_parent.add_match(1, 3, 0);
+        C_parent.add_match(1, 4, 0);
+        auto parent = pmondriaan::hierarchy();
+        parent.add_level(C_parent);
+        ASSERT_EQ(parent.levels(), 1);
+        ASSERT_EQ(parent.representative(4, 0), 2);
+
+        // the child only contains vertices 0 to 3
+        auto H_child = create_new_hypergraph(world, H, 0, 4);
+        auto C = pmondriaan::contraction();
+        auto HC = coarsen_hypergraph_projected(world, H_child, C, parent, 0);
+        ASSERT_EQ(HC.global_size(), 2);
+        ASSERT_EQ(HC(HC.local_id(0)).weight(), 2);
+        ASSERT_EQ(HC(HC.local_id(2)).weight(), 2);
+    });
+}
+
+} // namespace
+} // namespace pmondriaan
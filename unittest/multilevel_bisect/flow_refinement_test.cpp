@@ -0,0 +1,67 @@
+#include "pmondriaan.hpp"
+
+#include "gtest/gtest.h"
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+using environment = bulk::mpi::environment;
+#else
+#include <bulk/backends/thread/thread.hpp>
+using environment = bulk::thread::environment;
+#endif
+
+namespace pmondriaan {
+namespace {
+
+TEST(FlowRefinement, FlowRefine) {
+    auto H =
+    pmondriaan::read_hypergraph("../test/data/matrices/dolphins/dolphins.mtx", "degree")
+    .value();
+    pmondriaan::interval labels = {0, 1};
+    std::mt19937 rng(1);
+    bisect_random(H, 170, 170, 0, H.size(), labels, rng);
+
+    pmondriaan::options opts;
+    opts.metric = pmondriaan::m::cut_net;
+    auto C = init_counts(H);
+    auto weights = std::vector<long>({H.weight_part(0), H.weight_part(1)});
+    auto cut_before = pmondriaan::cutsize(H, C);
+    auto cut = flow_refine(H, C, weights, 170, 170, opts, cut_before);
+    ASSERT_EQ(cut, pmondriaan::cutsize(H, opts.metric));
+    ASSERT_LT(cut, cut_before);
+    ASSERT_EQ(weights[0], H.weight_part(0));
+    ASSERT_EQ(weights[1], H.weight_part(1));
+    ASSERT_LE(weights[0], 170);
+    ASSERT_LE(weights[1], 170);
+    check_C(H, C);
+}
+
+TEST(FlowRefinement, RecursiveBisectFlows) {
+    environment env;
+    env.spawn(1, [](bulk::world& world) {
+        auto H =
+        pmondriaan::read_hypergraph("../test/data/matrices/dolphins/dolphins.mtx", "degree")
+        .value();
+        std::mt19937 rng(1);
+        pmondriaan::options opts;
+        opts.sample_size = 30;
+        opts.KLFM_max_passes = 10;
+        opts.KLFM_max_no_gain_moves = 100;
+        opts.KLFM_par_number_send_moves = 4;
+        opts.metric = pmondriaan::m::lambda_minus_one;
+        opts.sampling_mode = pmondriaan::sampling::random;
+        opts.bisection_mode = pmondriaan::bisection::multilevel;
+        opts.coarsening_max_clustersize = 5;
+        opts.lp_max_iterations = 10;
+        opts.coarsening_nrvertices = 10;
+        opts.coarsening_maxrounds = 10;
+        opts.flow_refinement = true;
+        auto cut = recursive_bisect(world, H, 4, 0.05, 0.1, opts, rng, nullptr);
+        ASSERT_EQ(cut, pmondriaan::cutsize(world, H, opts.metric));
+        ASSERT_LE(pmondriaan::load_balance(world, H, 4), 0.05);
+    });
+}
+
+} // namespace
+} // namespace pmondriaan
@@ -1,5 +1,7 @@
 #include "pmondriaan.hpp"
 
+#include <algorithm>
+
 #include "gtest/gtest.h"
 
 namespace pmondriaan {
@@ -20,5 +22,85 @@ TEST(InitialPartitioning, initial_partitioning) {
     ASSERT_GE(sol, 6); 
 }
 
+TEST(InitialPartitioning, Portfolio) {
+    auto H =
+    pmondriaan::read_hypergraph("../test/data/matrices/dolphins/dolphins.mtx", "one")
+    .value();
+    std::mt19937 rng(1);
+    pmondriaan::options opts;
+    opts.KLFM_max_passes = 1;
+    opts.KLFM_max_no_gain_moves = 10;
+    opts.lp_max_iterations = 10;
+    opts.metric = pmondriaan::m::cut_net;
+
+    ASSERT_EQ(initial_algorithm(pmondriaan::initial::portfolio, 0),
+              pmondriaan::initial::label_propagation);
+    ASSERT_EQ(initial_algorithm(pmondriaan::initial::portfolio, 5), pmondriaan::initial::ghg);
+    ASSERT_EQ(initial_algorithm(pmondriaan::initial::portfolio, 6), pmondriaan::initial::bfs);
+    ASSERT_EQ(initial_algorithm(pmondriaan::initial::random, 4), pmondriaan::initial::random);
+
+    for (auto mode : {pmondriaan::initial::label_propagation, pmondriaan::initial::ghg,
+                      pmondriaan::initial::random, pmondriaan::initial::bfs,
+                      pmondriaan::initial::portfolio}) {
+        opts.initial_mode = mode;
+        // a processor that is beyond the budget still makes one attempt
+        opts.initial_attempts = 1;
+        auto sol = pmondriaan::initial_partitioning_attempts(H, 31, 31, opts, rng, 3, 4);
+        ASSERT_LE(H.weight_part(0), 31);
+        ASSERT_LE(H.weight_part(1), 31);
+        ASSERT_EQ(sol, cutsize(H, opts.metric));
+    }
+}
+
+TEST(InitialPartitioning, Threads) {
+    auto H =
+    pmondriaan::read_hypergraph("../test/data/matrices/dolphins/dolphins.mtx", "one")
+    .value();
+    std::mt19937 rng(1);
+    pmondriaan::options opts;
+    opts.KLFM_max_passes = 2;
+    opts.KLFM_max_no_gain_moves = 10;
+    opts.lp_max_iterations = 10;
+    opts.metric = pmondriaan::m::lambda_minus_one;
+    opts.threads = 4;
+    opts.initial_attempts = 12;
+
+    auto sol = pmondriaan::initial_partitioning(H, 31, 31, opts, rng);
+    ASSERT_LE(H.weight_part(0), 31);
+    ASSERT_LE(H.weight_part(1), 31);
+    ASSERT_EQ(sol, cutsize(H, opts.metric));
+
+    // with early termination a balanced solution is still found
+    opts.initial_attempts = 100;
+    opts.initial_max_no_improvement = 2;
+    sol = pmondriaan::initial_partitioning(H, 31, 31, opts, rng);
+    ASSERT_LE(H.weight_part(0), 31);
+    ASSERT_LE(H.weight_part(1), 31);
+    ASSERT_EQ(sol, cutsize(H, opts.metric));
+}
+
+TEST(InitialPartitioning, GreedyHypergraphGrowing) {
+    auto H =
+    pmondriaan::read_hypergraph("../test/data/matrices/dolphins/dolphins.mtx", "one")
+    .value();
+    std::mt19937 rng(1);
+
+    auto L = ghg_bisect(H, 31, 31, rng);
+    auto weight_0 = std::count(L.begin(), L.end(), 0);
+    ASSERT_EQ(weight_0, 31);
+
+    // growing a part gives a much lower cut than a random bisection
+    for (auto i = 0u; i < H.size(); i++) {
+        H(i).set_part(L[i]);
+    }
+    auto C = init_counts(H);
+    auto cut = cutsize(H, C);
+    for (auto i = 0u; i < H.size(); i++) {
+        H(i).set_part(rng() % 2);
+    }
+    auto C_random = init_counts(H);
+    ASSERT_LT(cut, cutsize(H, C_random));
+}
+
 } // namespace
 } // namespace pmondriaan
@@ -0,0 +1,65 @@
+#include "pmondriaan.hpp"
+
+#include "gtest/gtest.h"
+
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+using environment = bulk::mpi::environment;
+#else
+#include <bulk/backends/thread/thread.hpp>
+using environment = bulk::thread::environment;
+#endif
+
+namespace pmondriaan {
+namespace {
+
+TEST(Jet, JetRefinePar) {
+    environment env;
+    env.spawn(3, [](bulk::world& world) {
+        auto hypergraph =
+        read_hypergraph("../test/data/matrices/dolphins/dolphins.mtx", world, "degree");
+        auto H = hypergraph.value();
+        pmondriaan::interval labels = {0, 1};
+        std::mt19937 rng(world.rank() + 1);
+        bisect_random(H, 57, 57, 0, H.size(), labels, rng);
+
+        pmondriaan::options opts;
+        opts.metric = pmondriaan::m::lambda_minus_one;
+        auto C = init_counts(world, H);
+        auto cut_before = pmondriaan::cutsize(world, H, opts.metric);
+        auto cut = jet_refine_par(world, H, C, global_weight_part(world, H, 0),
+                                  global_weight_part(world, H, 1), 170, 170, opts);
+        ASSERT_EQ(cut, pmondriaan::cutsize(world, H, opts.metric));
+        ASSERT_LT(cut, cut_before);
+        ASSERT_LE(global_weight_part(world, H, 0), 170);
+        ASSERT_LE(global_weight_part(world, H, 1), 170);
+        check_C(world, H, C);
+    });
+}
+
+TEST(Jet, JetRebalance) {
+    environment env;
+    env.spawn(2, [](bulk::world& world) {
+        auto hypergraph =
+        read_hypergraph("../test/data/matrices/dolphins/dolphins.mtx", world, "degree");
+        auto H = hypergraph.value();
+        // everything starts in part 0, which is too heavy
+        for (auto& v : H.vertices()) {
+            v.set_part(0);
+        }
+
+        pmondriaan::options opts;
+        opts.metric = pmondriaan::m::lambda_minus_one;
+        auto C = init_counts(world, H);
+        auto total = global_weight(world, H);
+        auto max_weight = (long)(0.53 * (double)total);
+        auto cut = jet_refine_par(world, H, C, total, 0, max_weight, max_weight, opts);
+        ASSERT_EQ(cut, pmondriaan::cutsize(world, H, opts.metric));
+        ASSERT_LE(global_weight_part(world, H, 0), max_weight);
+        ASSERT_LE(global_weight_part(world, H, 1), max_weight);
+    });
+}
+
+} // namespace
+} // namespace pmondriaan
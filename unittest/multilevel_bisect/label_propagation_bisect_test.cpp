@@ -1,7 +1,18 @@
 #include "pmondriaan.hpp"
 
+#include <algorithm>
+
 #include "gtest/gtest.h"
 
+#include <bulk/bulk.hpp>
+#ifdef BACKEND_MPI
+#include <bulk/backends/mpi/mpi.hpp>
+using environment = bulk::mpi::environment;
+#else
+#include <bulk/backends/thread/thread.hpp>
+using environment = bulk::thread::environment;
+#endif
+
 namespace pmondriaan {
   namespace {
 
@@ -15,5 +26,87 @@ TEST(Bisect, BisectLP) {
     ASSERT_EQ(L.size(), H.size());
 }
 
+TEST(Bisect, LPManyLabels) {
+    auto H =
+    pmondriaan::read_hypergraph("../test/data/matrices/dolphins/dolphins.mtx", "degree")
+    .value();
+    std::mt19937 rng(1);
+    // the counts only store the labels present in a net, so many labels are cheap
+    long l = 1000000;
+    auto L = label_propagation(H, l, 10, 0, rng);
+    ASSERT_EQ(L.size(), H.size());
+    for (auto label : L) {
+        ASSERT_GE(label, 0);
+        ASSERT_LT(label, l);
+    }
+    // neighbouring vertices join each other's groups
+    auto distinct = L;
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    ASSERT_LT(distinct.size(), H.size());
+
+    pmondriaan::options opts;
+    opts.sample_size = 10000;
+    opts.lp_max_iterations = 10;
+    auto samples = sample_lp(H, opts, rng);
+    ASSERT_GT(samples.size(), 0u);
+    ASSERT_LE(samples.size(), H.size());
+    std::sort(samples.begin(), samples.end());
+    ASSERT_EQ(std::unique(samples.begin(), samples.end()), samples.end());
+}
+
+TEST(Bisect, BisectLPScratch) {
+    auto H =
+    pmondriaan::read_hypergraph("../test/data/matrices/dolphins/dolphins.mtx", "degree")
+    .value();
+    // a reused scratch space gives the same bisections as a new one
+    auto scratch = pmondriaan::lp_bisect_scratch();
+    for (auto seed = 1; seed <= 3; seed++) {
+        std::mt19937 rng(seed);
+        std::mt19937 rng_scratch(seed);
+        auto C = std::vector<std::vector<long>>(H.nets().size(), std::vector<long>(2, 0));
+        auto C_scratch = C;
+        auto L = label_propagation_bisect(H, C, 10, 170, 170, rng);
+        auto L_scratch =
+        label_propagation_bisect(H, C_scratch, 10, 170, 170, rng_scratch, &scratch);
+        ASSERT_EQ(L, L_scratch);
+        ASSERT_EQ(C, C_scratch);
+
+        long weight_0 = 0;
+        for (auto i = 0u; i < H.size(); i++) {
+            H(i).set_part(L[i]);
+            weight_0 += (L[i] == 0) ? H(i).weight() : 0;
+        }
+        ASSERT_LE(weight_0, 170);
+        ASSERT_LE(H.total_weight() - weight_0, 170);
+        ASSERT_EQ(C, init_counts(H));
+    }
+}
+
+TEST(Bisect, RefineLPPar) {
+    environment env;
+    env.spawn(3, [](bulk::world& world) {
+        auto hypergraph =
+        read_hypergraph("../test/data/matrices/dolphins/dolphins.mtx", world, "degree");
+        auto H = hypergraph.value();
+        pmondriaan::interval labels = {0, 1};
+        std::mt19937 rng(world.rank() + 1);
+        bisect_random(H, 57, 57, 0, H.size(), labels, rng);
+
+        pmondriaan::options opts;
+        opts.lp_max_iterations = 25;
+        opts.metric = pmondriaan::m::lambda_minus_one;
+        auto C = init_counts(world, H);
+        auto cut_before = pmondriaan::cutsize(world, H, opts.metric);
+        auto cut = label_propagation_refine_par(world, H, C, global_weight_part(world, H, 0),
+                                                global_weight_part(world, H, 1), 170,
+                                                170, opts, rng, cut_before);
+        ASSERT_EQ(cut, pmondriaan::cutsize(world, H, opts.metric));
+        ASSERT_LE(cut, cut_before);
+        ASSERT_LE(global_weight_part(world, H, 0), 170);
+        ASSERT_LE(global_weight_part(world, H, 1), 170);
+    });
+}
+
 } // namespace
 } // namespace mondriaan
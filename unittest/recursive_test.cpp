@@ -33,7 +33,7 @@ TEST(RecursiveBisect, SeqRecursiveBisect) {
         opts.lp_max_iterations = 10;
         opts.coarsening_nrvertices = 40;
         opts.coarsening_maxrounds = 1;
-        recursive_bisect(world, H, 7, 0.1, 0.1, opts);
+        auto cut = recursive_bisect(world, H, 7, 0.1, 0.1, opts);
         auto lb = pmondriaan::load_balance(world, H, 7);
         ASSERT_LE(lb, 0.1);
         for (auto v : H.vertices()) {
@@ -41,6 +41,149 @@ TEST(RecursiveBisect, SeqRecursiveBisect) {
         }
         ASSERT_EQ(old_size, H.size());
         ASSERT_EQ(old_nets, H.nets().size());
+        ASSERT_EQ(cut, pmondriaan::cutsize(world, H, opts.metric));
+    });
+}
+
+TEST(RecursiveBisect, SeqRecursiveBisectReuseHierarchy) {
+    environment env;
+    env.spawn(1, [](bulk::world& world) {
+        auto H = pmondriaan::read_hypergraph(
+                 "../test/data/matrices/dolphins/dolphins.mtx", "degree")
+                 .value();
+        auto old_size = H.size();
+        pmondriaan::options opts;
+        opts.KLFM_max_passes = 10;
+        opts.KLFM_max_no_gain_moves = 100;
+        opts.metric = pmondriaan::m::lambda_minus_one;
+        opts.bisection_mode = pmondriaan::bisection::multilevel;
+        opts.coarsening_max_clustersize = 3;
+        opts.lp_max_iterations = 10;
+        opts.coarsening_nrvertices = 10;
+        opts.coarsening_maxrounds = 10;
+        opts.coarsening_reuse = true;
+        recursive_bisect(world, H, 8, 0.1, 0.1, opts);
+        auto lb = pmondriaan::load_balance(world, H, 8);
+        ASSERT_LE(lb, 0.1);
+        for (auto v : H.vertices()) {
+            ASSERT_NE(v.part(), -1);
+        }
+        ASSERT_EQ(old_size, H.size());
+    });
+}
+
+TEST(RecursiveBisect, SeqRecursiveBisectThreads) {
+    environment env;
+    env.spawn(1, [](bulk::world& world) {
+        auto H = pmondriaan::read_hypergraph(
+                 "../test/data/matrices/dolphins/dolphins.mtx", "degree")
+                 .value();
+        auto old_size = H.size();
+        auto old_nets = H.nets().size();
+        pmondriaan::options opts;
+        opts.KLFM_max_passes = 10;
+        opts.KLFM_max_no_gain_moves = 100;
+        opts.metric = pmondriaan::m::lambda_minus_one;
+        opts.bisection_mode = pmondriaan::bisection::multilevel;
+        opts.coarsening_max_clustersize = 3;
+        opts.lp_max_iterations = 10;
+        opts.coarsening_nrvertices = 10;
+        opts.coarsening_maxrounds = 10;
+        opts.threads = 4;
+        recursive_bisect(world, H, 9, 0.1, 0.1, opts);
+        auto lb = pmondriaan::load_balance(world, H, 9);
+        ASSERT_LE(lb, 0.1);
+        for (auto v : H.vertices()) {
+            ASSERT_GE(v.part(), 0);
+            ASSERT_LT(v.part(), 9);
+        }
+        ASSERT_EQ(old_size, H.size());
+        ASSERT_EQ(old_nets, H.nets().size());
+        for (auto i = 0u; i < H.size(); i++) {
+            ASSERT_EQ(H.local_id(H(i).id()), i);
+        }
+    });
+}
+
+TEST(RecursiveBisect, ParRecursiveBisectBatch) {
+    environment env;
+    env.spawn(2, [](bulk::world& world) {
+        auto H = pmondriaan::read_hypergraph(
+                 "../test/data/matrices/dolphins/dolphins.mtx", world, "degree")
+                 .value();
+        auto old_size = bulk::sum(world, H.size());
+        pmondriaan::options opts;
+        opts.sample_size = 10;
+        opts.KLFM_max_passes = 10;
+        opts.KLFM_par_number_send_moves = 5;
+        opts.metric = pmondriaan::m::lambda_minus_one;
+        opts.bisection_mode = pmondriaan::bisection::multilevel;
+        opts.sampling_mode = pmondriaan::sampling::random;
+        opts.coarsening_max_clustersize = 5;
+        opts.lp_max_iterations = 10;
+        opts.coarsening_nrvertices = 20;
+        opts.coarsening_maxrounds = 10;
+
+        auto jobs = std::vector<pmondriaan::batch_job>{{2, 0.1, 1}, {4, 0.1, 2}, {3, 0.2, 3}};
+        auto finished = 0u;
+        recursive_bisect_batch(
+        world, H, jobs, 0.1, opts,
+        [&](const pmondriaan::batch_job& job, pmondriaan::hypergraph& H_job, long cut) {
+            ASSERT_EQ(job.seed, jobs[finished].seed);
+            ASSERT_EQ(cut, pmondriaan::cutsize(world, H_job, opts.metric));
+            ASSERT_LE(pmondriaan::load_balance(world, H_job, job.k), job.epsilon);
+            for (auto v : H_job.vertices()) {
+                ASSERT_GE(v.part(), 0);
+                ASSERT_LT(v.part(), job.k);
+            }
+            ASSERT_EQ(old_size, bulk::sum(world, H_job.size()));
+            finished++;
+        });
+        ASSERT_EQ(finished, jobs.size());
+        for (auto v : H.vertices()) {
+            ASSERT_EQ(v.part(), -1);
+        }
+    });
+}
+
+TEST(RecursiveBisect, SeqRecursiveBisectBatchThreads) {
+    environment env;
+    env.spawn(1, [](bulk::world& world) {
+        auto H = pmondriaan::read_hypergraph(
+                 "../test/data/matrices/dolphins/dolphins.mtx", "degree")
+                 .value();
+        pmondriaan::options opts;
+        opts.KLFM_max_passes = 10;
+        opts.KLFM_max_no_gain_moves = 100;
+        opts.metric = pmondriaan::m::lambda_minus_one;
+        opts.bisection_mode = pmondriaan::bisection::multilevel;
+        opts.coarsening_max_clustersize = 3;
+        opts.lp_max_iterations = 10;
+        opts.coarsening_nrvertices = 10;
+        opts.coarsening_maxrounds = 10;
+        opts.threads = 2;
+
+        // the first job fills the cache, the later jobs reuse it
+        auto first_levels = pmondriaan::coarsening_levels();
+        auto jobs = std::vector<pmondriaan::batch_job>{{4, 0.1, 1}, {3, 0.2, 2}};
+        const pmondriaan::hypergraph* cached = nullptr;
+        for (const auto& job : jobs) {
+            auto H_job = H;
+            std::mt19937 rng(job.seed);
+            auto cut =
+            recursive_bisect(world, H_job, job.k, job.epsilon, 0.1, opts, rng, &first_levels);
+            ASSERT_FALSE(first_levels.HC_list.empty());
+            if (cached == nullptr) {
+                cached = first_levels.HC_list.data();
+            }
+            ASSERT_EQ(first_levels.HC_list.data(), cached);
+            ASSERT_EQ(cut, pmondriaan::cutsize(world, H_job, opts.metric));
+            ASSERT_LE(pmondriaan::load_balance(world, H_job, job.k), job.epsilon);
+            for (auto v : H_job.vertices()) {
+                ASSERT_GE(v.part(), 0);
+                ASSERT_LT(v.part(), job.k);
+            }
+        }
     });
 }
 
@@ -71,7 +214,7 @@ TEST(RecursiveBisect, ParRecursiveBisect) {
         opts.coarsening_nrvertices = 40;
         opts.coarsening_maxrounds = 1;
         opts.KLFM_par_number_send_moves = 4;
-        recursive_bisect(world, H, 7, 0.1, 0.1, opts);
+        auto cut = recursive_bisect(world, H, 7, 0.1, 0.1, opts);
         auto lb = pmondriaan::load_balance(world, H, 7);
         auto new_size = bulk::sum(world, H.size());
         ASSERT_EQ(old_size, new_size);
@@ -92,6 +235,51 @@ TEST(RecursiveBisect, ParRecursiveBisect) {
             ASSERT_EQ(old_nets[i], new_nets[i]);
         }
         ASSERT_LE(lb, 0.1);
+        ASSERT_EQ(cut, pmondriaan::cutsize(world, H, opts.metric));
+    });
+}
+
+TEST(RecursiveBisect, ParRecursiveBisectWorkStealing) {
+    environment env;
+    env.spawn(3, [](bulk::world& world) {
+        auto H = pmondriaan::read_hypergraph(
+                 "../test/data/matrices/dolphins/dolphins.mtx", world, "degree")
+                 .value();
+        auto old_size = bulk::sum(world, H.size());
+        auto old_pins = 0u;
+        for (auto net : H.nets()) {
+            old_pins += net.size();
+        }
+        old_pins = bulk::sum(world, old_pins);
+        pmondriaan::options opts;
+        opts.sample_size = 30;
+        opts.KLFM_max_passes = 10;
+        opts.KLFM_max_no_gain_moves = 100;
+        opts.metric = pmondriaan::m::lambda_minus_one;
+        opts.sampling_mode = pmondriaan::sampling::random;
+        opts.bisection_mode = pmondriaan::bisection::multilevel;
+        opts.coarsening_max_clustersize = 5;
+        opts.lp_max_iterations = 10;
+        opts.coarsening_nrvertices = 10;
+        opts.coarsening_maxrounds = 10;
+        opts.KLFM_par_number_send_moves = 4;
+        opts.work_stealing = true;
+        auto cut = recursive_bisect(world, H, 13, 0.2, 0.1, opts);
+        auto lb = pmondriaan::load_balance(world, H, 13);
+        ASSERT_LE(lb, 0.2);
+        for (auto v : H.vertices()) {
+            ASSERT_GE(v.part(), 0);
+            ASSERT_LT(v.part(), 13);
+        }
+
+        // stolen vertices and their nets have been removed again
+        auto new_pins = 0u;
+        for (auto net : H.nets()) {
+            new_pins += net.size();
+        }
+        ASSERT_EQ(old_pins, bulk::sum(world, new_pins));
+        ASSERT_EQ(old_size, bulk::sum(world, H.size()));
+        ASSERT_EQ(cut, pmondriaan::cutsize(world, H, opts.metric));
     });
 }
 
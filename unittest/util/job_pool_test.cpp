@@ -0,0 +1,45 @@
+#include "pmondriaan.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+
+#include "gtest/gtest.h"
+
+namespace pmondriaan {
+namespace {
+
+TEST(JobPool, SplitsAllJobs) {
+    auto pool = pmondriaan::job_pool(4);
+    ASSERT_EQ(pool.threads(), 4);
+    pool.push(0, pmondriaan::work_item(0, 100, 0, 99, 100));
+
+    std::atomic<long> total_weight(0);
+    std::mutex labels_mutex;
+    auto labels = std::multiset<long>();
+    // every job is split in two halves until it has a single label
+    pool.run([&](size_t t, pmondriaan::work_item job) {
+        ASSERT_LT(t, 4u);
+        if (job.label_low() == job.label_high()) {
+            total_weight += job.weight();
+            std::lock_guard<std::mutex> lock(labels_mutex);
+            labels.insert(job.label_low());
+            return;
+        }
+        auto mid = (job.start() + job.end()) / 2;
+        auto label_mid = (job.label_low() + job.label_high()) / 2;
+        pool.push(t, pmondriaan::work_item(job.start(), mid, job.label_low(),
+                                           label_mid, mid - job.start()));
+        pool.push(t, pmondriaan::work_item(mid, job.end(), label_mid + 1,
+                                           job.label_high(), job.end() - mid));
+    });
+
+    ASSERT_EQ(total_weight, 100);
+    ASSERT_EQ(labels.size(), 100u);
+    for (auto label = 0; label < 100; label++) {
+        ASSERT_EQ(labels.count(label), 1u);
+    }
+}
+
+} // namespace
+} // namespace pmondriaan
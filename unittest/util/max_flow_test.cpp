@@ -0,0 +1,39 @@
+#include "pmondriaan.hpp"
+
+#include "gtest/gtest.h"
+
+namespace pmondriaan {
+namespace {
+
+TEST(MaxFlow, Compute) {
+    // the network from Cormen et al., with source 0 and sink 5
+    auto network = pmondriaan::max_flow(6);
+    network.add_edge(0, 1, 16);
+    network.add_edge(0, 2, 13);
+    network.add_edge(2, 1, 4);
+    network.add_edge(1, 3, 12);
+    network.add_edge(3, 2, 9);
+    network.add_edge(2, 4, 14);
+    network.add_edge(4, 3, 7);
+    network.add_edge(3, 5, 20);
+    network.add_edge(4, 5, 4);
+    ASSERT_EQ(network.compute(0, 5), 23);
+
+    auto source_side = network.reachable_from(0);
+    ASSERT_EQ(source_side, std::vector<bool>({true, true, true, false, true, false}));
+}
+
+TEST(MaxFlow, MinimumCuts) {
+    // a path whose first and last edge are both minimum cuts
+    auto network = pmondriaan::max_flow(4);
+    network.add_edge(0, 1, 1);
+    network.add_edge(1, 2, 5);
+    network.add_edge(2, 3, 1);
+    ASSERT_EQ(network.compute(0, 3), 1);
+
+    ASSERT_EQ(network.reachable_from(0), std::vector<bool>({true, false, false, false}));
+    ASSERT_EQ(network.reaching(3), std::vector<bool>({false, false, false, true}));
+}
+
+} // namespace
+} // namespace pmondriaan